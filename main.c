@@ -10,6 +10,30 @@
 #include <string.h>
 #include <time.h>
 #include <stdarg.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#ifdef __GLIBC__
+#include <execinfo.h>
+#define SAMPLER_AVAILABLE
+#endif
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+#ifdef CTALE_USE_LZ4
+#include <lz4.h>
+#endif
 
 // TELA:
 #define SCREEN_WIDTH 640
@@ -18,6 +42,7 @@
 // RENDERIZAÇÃO:
 #define WINDOW_FLAGS (SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE)
 #define RENDERER_FLAGS (SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC)
+#define HEADLESS_RENDERER_FLAGS (SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE)
 #define IMAGE_FLAGS (IMG_INIT_PNG)
 #define MIXER_FLAGS (MIX_INIT_MP3 | MIX_INIT_OGG)
 
@@ -25,11 +50,15 @@
 #define COLLISION_QUANTITY 12
 #define SURFACE_QUANTITY 13
 #define DIR_COUNT 4
+#define GAME_STATE_COUNT 6
+#define RESOURCE_STATE_STARTUP GAME_STATE_COUNT
 
 // LIMITES:
 #define MAX_OBJECT_AMOUNT 200
 #define MAX_DIALOGUE_CHAR 512
 #define MAX_DIALOGUE_STR 20
+#define MAX_DIALOGUE_PAGES 8
+#define PATH_LENGTH 512
 
 // GRANDEZAS:
 #define BASE_FONT_SIZE 24
@@ -39,10 +68,136 @@
 
 // CANAIS:
 #define DEFAULT_CHANNEL -1
-#define MUSIC_CHANNEL 0
 #define SFX_CHANNEL 2
 #define DIALOGUE_CHANNEL 3
 
+// MÚSICAS (TOCADAS EM STREAMING, UMA POR VEZ):
+#define CUTSCENE_MUSIC_PATH "assets/sounds/soundtracks/the_story_of_a_hero.wav"
+#define BATTLE_MUSIC_PATH "assets/sounds/soundtracks/battle_against_abstraction.wav"
+#define AMBIENCE_MUSIC_PATH "assets/sounds/sound_effects/in-game/ambient_sound.wav"
+
+// ATLAS:
+#define SPRITES_DIR "assets/sprites"
+#define ATLAS_DIR "assets/atlas"
+#define ATLAS_INDEX_PATH ATLAS_DIR "/atlas.txt"
+#define ATLAS_PAGE_SIZE 2048
+#define ATLAS_MAX_SPRITE 512
+#define ATLAS_PADDING 2
+
+// PACOTE DE ASSETS:
+#define ASSETS_DIR "assets"
+#define PACK_PATH "assets.pak"
+#define PACK_MAGIC "CTPK"
+#define PACK_VERSION 1
+#define PACK_PATH_LENGTH 128
+#define PACK_ALIGNMENT 16
+#define PACK_FLAG_LZ4 0x1
+
+// CARREGADOR:
+#define SOUNDS_DIR "assets/sounds"
+#define LOADER_MAX_THREADS 16
+
+// PERFIL DE INICIALIZAÇÃO:
+#define STARTUP_TRACE_PATH "startup-trace.json"
+#define STARTUP_BENCH_PATH "startup-bench.csv"
+#define STARTUP_TOP_N 10
+
+// ATLAS DE GLIFOS:
+#define GLYPH_ATLAS_SIZE 512
+#define GLYPH_ATLAS_PADDING 1
+
+// CAMADAS DE FUNDO EM CACHE:
+#define LAYER_CACHE_MAX 8
+
+// RESULTADO DO RECORTE CONTRA A TELA:
+#define CULL_VISIBLE 0
+#define CULL_CLIPPED 1
+#define CULL_OUTSIDE 2
+
+// RETÂNGULOS SUJOS:
+#define DIRTY_MAX_PROPS 8
+
+// FILA DE DESENHO (CAMADAS EM ORDEM DE ENVIO E PROFUNDIDADES ESPECIAIS):
+#define RENDER_LAYER_BACKGROUND 1
+#define RENDER_LAYER_ACTORS 2
+#define RENDER_LAYER_FOREGROUND 3
+#define RENDER_LAYER_DEBUG 4
+#define RENDER_DEPTH_ORDERED -1
+#define RENDER_DEPTH_GROUP -2
+#define RENDER_DEPTH_BIAS 0x800000
+#define RENDER_FILL_RUN 64
+
+// INTERPOLAÇÃO DE DESENHO ENTRE TICKS:
+#define RENDER_TRACK_SLOTS 1024
+#define RENDER_LERP_MAX_STEP 48.0f
+
+// SIMULAÇÃO EM PASSO FIXO (AS VELOCIDADES DO JOGO SÃO EM PIXELS POR TICK):
+#define SIM_TICK_RATE 60
+#define SIM_DT (1.0 / SIM_TICK_RATE)
+#define SIM_MAX_FRAME 0.25
+
+// RITMO DE QUADROS (TEMPOS EM SEGUNDOS):
+#define PACER_HISTORY 8
+#define PACER_SNAP_TOLERANCE 0.0005
+#define PACER_SPIN_START 0.002
+#define PACER_SPIN_MIN 0.0005
+#define PACER_SPIN_MAX 0.004
+
+// HUD DE DESEMPENHO:
+#define PERF_HISTORY 240
+#define PERF_GRAPH_HEIGHT 40
+
+// ZONAS DE TRACE (UM ANEL POR THREAD; GRAVADAS COM --trace OU --perf-counters, OU A PARTIR DO PRIMEIRO F8, QUE DEPOIS DESPEJA):
+#define TRACE_RING_SIZE 65536
+#define TRACE_RING_SLACK 1024
+#define TRACE_MAX_THREADS (LOADER_MAX_THREADS + 4)
+#define TRACE_DUMP_FORMAT "trace-%03d.json"
+#define TRACE_EXIT_PATH "trace.json"
+
+// GRAVADOR DE VOO (ÚLTIMOS QUADROS, DESPEJADOS QUANDO UM QUADRO ESTOURA O ORÇAMENTO).
+// O anel guarda FLIGHT_FRAMES quadros, não segundos: os FLIGHT_SECONDS só são cobertos até 120 fps;
+// acima disso (ou sem limite) a janela despejada é mais curta, e o arquivo registra a duração real.
+#define FLIGHT_FRAMES 600
+#define FLIGHT_SECONDS 5.0
+#define FLIGHT_ZONES 16
+#define FLIGHT_BUDGET_MS 33.3
+#define FLIGHT_WARMUP_FRAMES 30
+#define FLIGHT_COOLDOWN 10.0
+#define FLIGHT_MAX_DUMPS 20
+#define FLIGHT_KEY_COUNT 10
+#define FLIGHT_DUMP_FORMAT "flight-%03d.json"
+#define FLIGHT_TRACE_FORMAT "flight-%03d-trace.json"
+
+// CONTADORES DE HARDWARE POR ZONA (perf_event_open, SÓ NO LINUX):
+#define COUNTER_ZONES 32
+#define COUNTER_STACK 32
+#define COUNTERS_REPORT_PATH "perf-counters.json"
+
+// PERFILADOR POR AMOSTRAGEM (PILHAS DOBRADAS PARA FLAMEGRAPH):
+#define SAMPLER_DEFAULT_RATE 499
+#define SAMPLER_DEPTH 48
+#define SAMPLER_SKIP 2
+#define SAMPLER_RING_SIZE 4096
+#define SAMPLER_STACKS_START 1024
+#define SAMPLER_OUTPUT_PATH "profile.folded"
+#if defined(__GNUC__) || defined(__clang__)
+#define TRACE_ZONE(zone_name) TraceScope trace_scope __attribute__((cleanup(trace_scope_end))) = {(zone_name), trace_begin()}
+#else
+#define TRACE_ZONE(zone_name) (void)0
+#endif
+
+// TEXTO NUMÉRICO DO HUD:
+#define HUD_DIGITS "0123456789/x"
+#define HUD_TEXT_LENGTH 16
+
+// RESIDÊNCIA:
+#define STATE_BIT(state) (1u << (state))
+#define ALL_STATES 0xFFFFFFFFu
+#define PREFETCH_MARGIN 96
+
+// CONTABILIDADE DE RECURSOS:
+#define RESOURCE_REPORT_PATH "resource-report.json"
+
 // TÍTULO:
 #define GAME_TITLE "C-Tale: Meneghetti Vs Python"
 
@@ -52,9 +207,237 @@ typedef struct {
     SDL_Renderer *renderer;
 } Game;
 
-// PERSONAGEM:
+// SPRITE (REGIÃO DE UMA TEXTURA OU DE UMA PÁGINA DE ATLAS):
+typedef struct {
+    SDL_Texture *texture;
+    SDL_Rect src;
+    int w, h;
+    Uint8 alpha;
+    int resident;
+} Sprite;
+
+// ENTRADA DO ÍNDICE DE ATLAS:
+typedef struct {
+    char *path;
+    int page;
+    SDL_Rect rect;
+} AtlasEntry;
+
+// IMAGEM DE ORIGEM PARA O EMPACOTADOR DE ATLAS:
+typedef struct {
+    char *path;
+    char bucket[64];
+    SDL_Surface *surface;
+    int page;
+    SDL_Rect rect;
+} AtlasSource;
+
+// CABEÇALHO DO PACOTE DE ASSETS (ordem de bytes nativa):
+typedef struct {
+    char magic[4];
+    Uint32 version;
+    Uint32 entry_count;
+    Uint32 index_offset;
+} PackHeader;
+
+// ENTRADA DO ÍNDICE DO PACOTE:
+typedef struct {
+    char path[PACK_PATH_LENGTH];
+    Uint32 offset;
+    Uint32 size;
+    Uint32 stored_size;
+    Uint32 flags;
+} PackEntry;
+
+// TIPO DE RECURSO REGISTRADO:
+enum resource_kinds { RESOURCE_TEXTURE, RESOURCE_CHUNK, RESOURCE_FONT, RESOURCE_MUSIC, RESOURCE_KIND_COUNT };
+
+// HANDLE GERACIONAL DE RECURSO (SLOT + 1 E GERAÇÃO):
+typedef struct {
+    Uint32 slot;
+    Uint32 generation;
+} ResourceHandle;
+
+// SLOT DO REGISTRO DE RECURSOS (CADA REFERÊNCIA É DE UM DONO: ENTRADA DO CACHE, RESIDÊNCIA OU ATLAS DE GLIFOS):
+typedef struct {
+    void *pointer;
+    Uint32 generation;
+    int kind;
+    int refcount;
+    size_t bytes;
+    int w, h;
+    Uint32 format;
+    char name[PATH_LENGTH];
+    int next_free;
+} ResourceSlot;
+
+// REGISTRO DE RECURSOS (ENDEREÇAMENTO ABERTO POR PONTEIRO; O QUE CARREGA ANTES DO LOOP CONTA NO BALDE "startup"):
+typedef struct {
+    ResourceSlot *slots;
+    int slot_count;
+    int slot_capacity;
+    int free_head;
+    int *index;
+    int index_capacity;
+    int index_used;
+    int tombstones;
+    int live[RESOURCE_KIND_COUNT];
+    int peak[RESOURCE_KIND_COUNT];
+    size_t bytes[RESOURCE_KIND_COUNT];
+    int state;
+    int state_peak[GAME_STATE_COUNT + 1][RESOURCE_KIND_COUNT];
+    size_t state_peak_bytes[GAME_STATE_COUNT + 1][RESOURCE_KIND_COUNT];
+    Uint64 registrations;
+    Uint64 releases;
+    Uint64 lookups;
+    Uint64 probes;
+} ResourceRegistry;
+
+// ESTATÍSTICAS DO REGISTRO:
+typedef struct {
+    int live[RESOURCE_KIND_COUNT];
+    int peak[RESOURCE_KIND_COUNT];
+    size_t bytes[RESOURCE_KIND_COUNT];
+    Uint64 registrations;
+    Uint64 releases;
+    double average_probes;
+} ResourceStats;
+
+// GLIFO RASTERIZADO NUM ATLAS DE TEXTO:
+typedef struct {
+    Uint32 codepoint;
+    int page;
+    SDL_Rect rect;
+} Glyph;
+
+// ATLAS DE GLIFOS POR (FONTE, COR), PREENCHIDO SOB DEMANDA EM PRATELEIRAS; GANHA PÁGINAS AO ENCHER:
+typedef struct {
+    TTF_Font *font;
+    SDL_Color color;
+    SDL_Renderer *render;
+    ResourceHandle *pages;
+    int page_count;
+    Glyph *glyphs;
+    int glyph_count;
+    int glyph_capacity;
+    int *slots;
+    int slot_capacity;
+    int shelf_x, shelf_y, shelf_h;
+} GlyphAtlas;
+
+// LOTE DE QUADS DE GLIFOS, ENVIADO NUMA CHAMADA DE SDL_RenderGeometry POR PÁGINA DO ATLAS:
+typedef struct {
+    GlyphAtlas *atlas;
+    SDL_Vertex *vertices;
+    int *quad_pages;
+    int quad_count;
+    int quad_capacity;
+} TextBatch;
+
+// TEXTO DE HUD RETIDO, RECOMPOSTO A PARTIR DA STRIP DE DÍGITOS SÓ QUANDO O VALOR MUDA:
+typedef struct {
+    GlyphAtlas *atlas;
+    const char *format;
+    int value;
+    bool dirty;
+    int glyphs[HUD_TEXT_LENGTH];
+    int glyph_count;
+    SDL_Rect collision;
+} HudText;
+
+// CONTADORES DE DESENHO DE TEXTO (QUADS ENVIADOS CONTRA CHAMADAS AO RENDERIZADOR):
+typedef struct {
+    Uint64 quads;
+    Uint64 draw_calls;
+} TextStats;
+
+// ENTRADA DO CACHE DE ASSETS:
+typedef struct {
+    char *key;
+    Uint64 content_hash;
+    void *handle;
+} CacheEntry;
+
+// CACHE DE ASSETS (INDEXADO POR CAMINHO E POR CONTEÚDO):
+typedef struct {
+    CacheEntry *entries;
+    int count;
+    int capacity;
+    int *key_slots;
+    int *content_slots;
+    int slot_capacity;
+    int hits;
+    int content_hits;
+} AssetCache;
+
+// TAREFA DE DECODIFICAÇÃO DO CARREGADOR:
 typedef struct {
+    char *path;
+    size_t bytes;
+    bool is_audio;
+    bool requested;
+    bool done;
+    SDL_Surface *surface;
+    Uint64 content_hash;
+    Mix_Chunk *chunk;
+    Uint64 decode_ticks;
+} LoadJob;
+
+// CARREGADOR PARALELO DE ASSETS:
+typedef struct {
+    LoadJob *jobs;
+    int job_count;
+    int *slots;
+    int slot_capacity;
+    SDL_atomic_t next_job;
+    SDL_mutex *mutex;
+    SDL_cond *job_done;
+    SDL_Thread *threads[LOADER_MAX_THREADS];
+    int thread_count;
+    Uint64 start_ticks;
+    Uint64 wait_ticks;
+    bool started;
+} AssetLoader;
+
+// EVENTO DO PERFIL DE INICIALIZAÇÃO:
+typedef struct {
+    char *name;
+    const char *category;
+    Uint64 start;
+    Uint64 end;
+    SDL_threadID thread;
+    size_t bytes;
+} ProfileEvent;
+
+// PERFIL DE INICIALIZAÇÃO:
+typedef struct {
+    ProfileEvent *events;
+    int count;
+    int capacity;
+    SDL_mutex *mutex;
+    Uint64 start;
+    bool enabled;
+    const char *benchmark;
+} StartupProfiler;
+
+// REGRA DE RESIDÊNCIA (PREFIXO DE CAMINHO -> ESTADOS QUE USAM O ASSET):
+typedef struct {
+    const char *prefix;
+    Uint32 states;
+} ResidencyRule;
+
+// TEXTURA COM RESIDÊNCIA CONTROLADA:
+typedef struct {
+    char *path;
     SDL_Texture *texture;
+    SDL_Surface *pending;
+    Uint32 states;
+    size_t bytes;
+} ResidentTexture;
+
+// PERSONAGEM:
+typedef struct {
+    Sprite *sprite;
     SDL_Rect collision;
     SDL_Rect interact_collision;
     double sprite_vel;
@@ -67,14 +450,14 @@ typedef struct {
 
 // OBJETO ESTÁTICO:
 typedef struct {
-    SDL_Texture* texture;
+    Sprite *sprite;
     SDL_Rect collision;
     int facing;
 } Prop;
 
 // PARÂMETROS DE ANIMAÇÃO:
 typedef struct {
-    SDL_Texture **frames;
+    Sprite **frames;
     double timer;
     int counter;
     int count;
@@ -82,19 +465,38 @@ typedef struct {
 
 // PROJÉTIL DE PRECISÃO:
 typedef struct {
-    SDL_Texture* texture;
+    Sprite *sprite;
     SDL_FRect collision;
     Animation animation;
 } Projectile;
 
+// GLIFO POSICIONADO NO LAYOUT DE UM DIÁLOGO (RELATIVO À CAIXA DE TEXTO):
+typedef struct {
+    int glyph;
+    int x, y;
+    int byte;
+} LaidGlyph;
+
+// LAYOUT PRÉ-CALCULADO DE UMA STRING DE DIÁLOGO:
+typedef struct {
+    LaidGlyph glyphs[MAX_DIALOGUE_CHAR];
+    int glyph_count;
+    int byte_count;
+    int page_start[MAX_DIALOGUE_PAGES];
+    int page_count;
+    int str;
+    SDL_Rect box;
+} TextLayout;
+
 // PARÂMETROS DE DIÁLOGO:
 typedef struct {
     char *writings[MAX_DIALOGUE_STR];
     int on_frame[MAX_DIALOGUE_STR];
     TTF_Font *text_font;
     SDL_Color text_color;
-    SDL_Texture *chars[MAX_DIALOGUE_CHAR];
-    char chars_string[MAX_DIALOGUE_CHAR][5];
+    GlyphAtlas *atlas;
+    TextLayout layout;
+    int page;
     int char_count;
     SDL_Rect text_box;
     int cur_str, cur_byte;
@@ -108,15 +510,310 @@ typedef struct {
     bool has_played;
 } Sound;
 
-// PACOTE DE RENDERIZAÇÃO:
+// MÚSICA:
+typedef struct {
+    Mix_Music *music;
+    bool has_played;
+} Music;
+
+// SOM COM RESIDÊNCIA CONTROLADA:
+typedef struct {
+    char *path;
+    Sound *sound;
+    Mix_Chunk *chunk;
+    Mix_Chunk *pending;
+    int volume;
+    Uint32 states;
+    Mix_Chunk *placeholder;
+} ResidentSound;
+
+// GRUPOS DE RESIDÊNCIA POR ESTADO DE JOGO:
+typedef struct {
+    ResidentTexture *textures;
+    int texture_count;
+    int texture_capacity;
+    ResidentSound *sounds;
+    int sound_count;
+    int sound_capacity;
+    int state;
+    int startup_state;
+    SDL_Thread *prefetch_thread;
+    int prefetch_state;
+    SDL_atomic_t prefetch_done;
+    size_t resident_bytes;
+    int prefetched;
+    int faults;
+} Residency;
+
+// CAMADA DESENHADA NUM CACHE DE COMPOSIÇÃO:
+typedef struct {
+    Sprite *sprite;
+    SDL_Texture *texture;
+    SDL_Rect dst;
+} CachedLayer;
+
+// CAMADAS DE FUNDO COMPOSTAS NUM ALVO DE RENDERIZAÇÃO, REDESENHADAS SÓ QUANDO MUDAM:
+typedef struct {
+    SDL_Texture *target;
+    CachedLayer layers[LAYER_CACHE_MAX];
+    int layer_count;
+    CachedLayer drawn[LAYER_CACHE_MAX];
+    int drawn_count;
+    bool valid;
+    Uint64 recomposed;
+    Uint64 reused;
+} LayerCache;
+
+// CONTAGEM DE SPRITES DESENHADOS, RECORTADOS E DESCARTADOS NUM FRAME:
+typedef struct {
+    int drawn;
+    int clipped;
+    int culled;
+} CullCounts;
+
+// ESTATÍSTICAS DE RECORTE (FRAME ATUAL, ÚLTIMO FRAME E TOTAIS):
+typedef struct {
+    CullCounts frame;
+    CullCounts last;
+    Uint64 total_culled;
+    Uint64 total_clipped;
+    Uint64 frames;
+} CullStats;
+
+// PROP ACOMPANHADO PELO RENDERIZADOR DE RETÂNGULOS SUJOS:
+typedef struct {
+    Sprite *sprite;
+    SDL_Rect rect;
+} DirtyProp;
+
+// RENDERIZADOR DE RETÂNGULOS SUJOS (OPCIONAL): REPINTA SÓ O DANO NUM BACKBUFFER PERSISTENTE:
+typedef struct {
+    bool enabled;
+    bool active;
+    bool full;
+    bool damaged;
+    SDL_Texture *backbuffer;
+    int screen;
+    SDL_Rect damage;
+    SDL_Rect clip;
+    DirtyProp props[DIRTY_MAX_PROPS];
+    Uint64 frames;
+    Uint64 repainted_pixels;
+} DirtyRenderer;
+
+// TIPO DE COMANDO DA FILA DE DESENHO:
+enum render_commands { RENDER_CLEAR, RENDER_COPY, RENDER_FILL, RENDER_GEOMETRY };
+
+// COMANDO DE DESENHO GRAVADO (CHAVE = CAMADA, PROFUNDIDADE, ESTADO E ORDEM DE ENVIO):
+typedef struct {
+    Uint64 key;
+    int type;
+    SDL_Texture *texture;
+    SDL_Rect src;
+    bool has_src;
+    SDL_FRect dst;
+    SDL_FRect from;
+    bool lerp;
+    double angle;
+    SDL_RendererFlip flip;
+    SDL_Color color;
+    SDL_BlendMode blend;
+    int first_vertex;
+    int quad_count;
+} RenderCommand;
+
+// ÚLTIMAS POSIÇÕES DE UM RETÂNGULO DESENHADO (IDENTIFICADO PELO ENDEREÇO):
+typedef struct {
+    const void *id;
+    Uint32 tick;
+    SDL_FRect previous;
+    SDL_FRect current;
+    int draws;
+    bool ambiguous;
+} RenderTrack;
+
+// CONTADORES DE UM QUADRO DA FILA DE DESENHO:
+typedef struct {
+    int commands;
+    int draw_calls;
+    int state_changes;
+    int elided;
+    int dropped;
+    int binds;
+} RenderQueueStats;
+
+// FILA DE DESENHO ADIADA, ORDENADA E ENVIADA NO FIM DO QUADRO:
+typedef struct {
+    RenderCommand *commands;
+    int count;
+    int capacity;
+    int flushed;
+    SDL_Vertex *vertices;
+    int vertex_count;
+    int vertex_capacity;
+    int *indices;
+    int index_quads;
+    int layer;
+    int depth;
+    Uint32 group_depth;
+    Uint32 sequence;
+    SDL_Color color;
+    SDL_BlendMode blend;
+    bool applied_valid;
+    SDL_Color applied_color;
+    SDL_BlendMode applied_blend;
+    SDL_Texture *alpha_texture;
+    Uint8 alpha;
+    bool immediate;
+    bool discard;
+    bool replayable;
+    Uint32 tick;
+    RenderTrack tracks[RENDER_TRACK_SLOTS];
+    int track_count;
+    int track_state;
+    RenderQueueStats frame, last;
+    Uint64 total_commands, total_draw_calls, total_elided;
+    Uint64 frames;
+} RenderQueue;
+
+// RELÓGIO DA SIMULAÇÃO (TICKS FIXOS PENDENTES E FRAÇÃO PARA INTERPOLAR O DESENHO):
+typedef struct {
+    double accumulator;
+    int pending;
+    double alpha;
+    Uint64 ticks;
+    Uint64 frames;
+    Uint64 replays;
+    int stalls;
+    double dropped;
+} SimClock;
+
+// RITMO DE QUADROS (LIMITADOR COM SONO E ESPERA ATIVA, E SUAVIZAÇÃO DO TEMPO DE QUADRO):
+typedef struct {
+    bool vsync_requested;
+    bool vsync;
+    int target_rate;
+    int refresh_rate;
+    Uint64 frequency;
+    Uint64 period;
+    Uint64 deadline;
+    Uint64 last_frame;
+    double spin;
+    double history[PACER_HISTORY];
+    int history_count;
+    int history_next;
+    double residual;
+    double smoothed;
+    Uint64 frames;
+    double slept, spun;
+} FramePacer;
+
+// FASES MEDIDAS DE UM QUADRO:
+enum perf_phases { PERF_INPUT, PERF_UPDATE, PERF_SUBMIT, PERF_PRESENT, PERF_PHASE_COUNT };
+
+// CONTADORES DE HARDWARE LIDOS EM CADA ZONA:
+enum hardware_counters { COUNTER_CYCLES, COUNTER_INSTRUCTIONS, COUNTER_L1D_MISSES, COUNTER_LLC_MISSES, COUNTER_BRANCH_MISSES, COUNTER_COUNT };
+
+// HUD DE DESEMPENHO (FASES POR ESTADO E HISTÓRICO DE TEMPOS DE QUADRO; ENTRADA E ATUALIZAÇÃO SÃO POR TICK,
+// ENVIO E PRESENT POR QUADRO SIMULADO, E QUADROS REENVIADOS FICAM À PARTE):
+typedef struct {
+    Uint64 frequency;
+    Uint64 mark;
+    Uint64 frame_start;
+    double phase[PERF_PHASE_COUNT];
+    double pass[PERF_PHASE_COUNT];
+    double state_total[GAME_STATE_COUNT][PERF_PHASE_COUNT];
+    Uint64 state_ticks[GAME_STATE_COUNT];
+    Uint64 state_frames[GAME_STATE_COUNT];
+    double replay_total[GAME_STATE_COUNT][PERF_PHASE_COUNT];
+    Uint64 replay_frames[GAME_STATE_COUNT];
+    double history[PERF_HISTORY];
+    int history_count;
+    int history_next;
+} PerfHud;
+
+// EVENTO DE UMA ZONA DE TRACE (O NOME É SEMPRE UMA STRING ESTÁTICA):
+typedef struct {
+    const char *name;
+    Uint64 start;
+    Uint64 end;
+} TraceEvent;
+
+// ANEL DE EVENTOS DE UMA THREAD (UM ÚNICO ESCRITOR, SEM TRAVAS):
+typedef struct {
+    SDL_threadID thread;
+    const char *name;
+    TraceEvent *events;
+    SDL_atomic_t head;
+    SDL_atomic_t ready;
+} TraceRing;
+
+// ZONA ABERTA NO ESCOPO ATUAL (FECHADA PELO cleanup AO SAIR DELE):
+typedef struct {
+    const char *name;
+    Uint64 start;
+} TraceScope;
+
+// COLETOR DE ZONAS DE TRACE:
+typedef struct {
+    TraceRing rings[TRACE_MAX_THREADS];
+    TraceRing overflow;
+    SDL_atomic_t ring_count;
+    SDL_TLSID tls;
+    Uint64 origin;
+    bool enabled;
+    bool dump_on_exit;
+    int dumps;
+} Tracer;
+
+// TOTAIS DOS CONTADORES DE UMA ZONA POR ESTADO (INCLUSIVOS, COMO OS TEMPOS DO TRACE):
+typedef struct {
+    const char *name;
+    Uint64 calls[GAME_STATE_COUNT];
+    Uint64 values[GAME_STATE_COUNT][COUNTER_COUNT];
+} CounterZone;
+
+// LEITURA DOS CONTADORES NA ABERTURA DE UMA ZONA (COM OS TEMPOS HABILITADO/RODANDO DO GRUPO):
+typedef struct {
+    Uint64 start;
+    Uint64 values[COUNTER_COUNT];
+    Uint64 time_enabled;
+    Uint64 time_running;
+} CounterMark;
+
+// CONTADORES DE HARDWARE DA THREAD PRINCIPAL:
+typedef struct {
+    bool requested;
+    bool enabled;
+    bool kernel;
+    SDL_threadID thread;
+    int fds[COUNTER_COUNT];
+    int slot[COUNTER_COUNT];
+    int opened;
+    int leader;
+    int state;
+    CounterMark stack[COUNTER_STACK];
+    int depth;
+    CounterZone zones[COUNTER_ZONES];
+    int zone_count;
+    Uint64 dropped;
+    Uint64 time_enabled;
+    Uint64 time_running;
+} HardwareCounters;
+
+// EXECUÇÃO SEM TELA NOS DRIVERS DUMMY (BENCHMARKS E TESTES DE RESISTÊNCIA):
 typedef struct {
-    SDL_Texture* texture;
-    SDL_Rect *collisions;
-} RenderItem;
+    bool enabled;
+    int frame_limit;
+    Uint64 frames;
+    Uint64 started;
+    Uint64 last;
+    double worst;
+} Headless;
 
 // FRAME DE CUTSCENE:
 typedef struct {
-    SDL_Texture* image;
+    Sprite *image;
     Text* text;
     double duration;
 } CutsceneFrame;
@@ -171,6 +868,88 @@ typedef struct {
     int death_count;
 } GameState;
 
+// TEMPO SOMADO DE UMA ZONA DE TRACE DENTRO DE UM QUADRO:
+typedef struct {
+    const char *name;
+    float ms;
+    int count;
+} FlightZone;
+
+// QUADRO GUARDADO PELO GRAVADOR DE VOO:
+typedef struct {
+    Uint64 frame;
+    double time;
+    float frame_ms;
+    float phase_ms[PERF_PHASE_COUNT];
+    FlightZone zones[FLIGHT_ZONES];
+    int zone_count;
+    GameState flags;
+    Uint32 keys;
+    int mouse_x, mouse_y;
+    Uint32 mouse_buttons;
+    int channels_playing;
+    int draw_calls;
+} FlightFrame;
+
+// GRAVADOR DE VOO:
+typedef struct {
+    FlightFrame frames[FLIGHT_FRAMES];
+    int count;
+    int next;
+    Uint64 frame_index;
+    int seen_head;
+    double budget;
+    Uint64 origin;
+    double last_dump;
+    int dumps;
+    SDL_Thread *writer;
+    SDL_atomic_t writing;
+    FlightFrame *pending;
+    int pending_count;
+    FlightFrame pending_trigger;
+    int pending_dump;
+} FlightRecorder;
+
+// AMOSTRA DO PERFILADOR (PILHA E ESTADO NO MOMENTO DO SINAL):
+typedef struct {
+    void *frames[SAMPLER_DEPTH];
+    int depth;
+    int game_state;
+    int battle_state;
+    int battle_turn;
+} Sample;
+
+// PILHA DISTINTA E QUANTAS AMOSTRAS CAÍRAM NELA:
+typedef struct {
+    Uint64 hash;
+    Uint64 count;
+    Sample sample;
+} SampleStack;
+
+// PERFILADOR POR AMOSTRAGEM (SIGPROF NO TEMPO DE CPU DA THREAD PRINCIPAL):
+typedef struct {
+    int rate;
+    bool enabled;
+    const GameState *flags;
+    Sample *ring;
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+    SDL_atomic_t dropped;
+    SampleStack *stacks;
+    int capacity;
+    int unique;
+    Uint64 samples;
+#ifdef SAMPLER_AVAILABLE
+    timer_t timer;
+#endif
+} Sampler;
+
+// LINHA DAS PILHAS DOBRADAS JÁ COM SÍMBOLOS:
+typedef struct {
+    char *text;
+    Uint64 count;
+} FoldedLine;
+
 // DIREÇÕES DE FRENTE DE SPRITE:
 enum direction { UP, DOWN, LEFT, RIGHT };
 // ESTADOS DO JOGO:
@@ -196,14 +975,226 @@ void game_reset(GameState *game);
 SDL_Texture *create_texture(SDL_Renderer *render, const char *dir);
 Mix_Chunk *create_chunk(const char *dir, int volume);
 TTF_Font *create_font(const char *dir, int size);
+Mix_Music *create_music(const char *dir);
+void play_music(Music *music, int loops);
+static bool is_streamed_music(const char *path);
 SDL_Texture *create_text(SDL_Renderer *render, const char *utf8_char, TTF_Font *font, SDL_Color color);
 
+// FUNÇÕES DE SPRITE E ATLAS:
+Sprite *create_sprite(SDL_Renderer *render, const char *dir);
+Sprite *sprite_from_texture(SDL_Texture *texture);
+void sprite_assign_texture(Sprite *sprite, SDL_Texture *texture);
+void sprite_set_alpha(Sprite *sprite, Uint8 alpha);
+static bool sprite_ready(SDL_Renderer *render, Sprite *sprite);
+void render_sprite(SDL_Renderer *render, Sprite *sprite, const SDL_Rect *dst);
+void render_sprite_ex(SDL_Renderer *render, Sprite *sprite, const SDL_Rect *dst, double angle, SDL_RendererFlip flip);
+void render_sprite_f(SDL_Renderer *render, Sprite *sprite, const SDL_FRect *dst);
+void render_sprite_exf(SDL_Renderer *render, Sprite *sprite, const SDL_FRect *dst, double angle, SDL_RendererFlip flip);
+static bool cull_outside(const SDL_FRect *dst);
+static int cull_rect(const SDL_Rect *src, const SDL_FRect *dst, SDL_Rect *clipped_src, SDL_FRect *clipped_dst);
+static void render_culled(SDL_Renderer *render, Sprite *sprite, const SDL_FRect *dst, const SDL_FRect *from);
+void cull_stats_frame(void);
+int cull_overlay(SDL_Renderer *render, GlyphAtlas *atlas, int x, int y);
+bool atlas_load(const char *index_path);
+static const AtlasEntry *atlas_find(const char *path);
+void atlas_unload(void);
+bool build_atlas(const char *sprites_dir, const char *out_dir);
+
+// FUNÇÕES DO ATLAS DE GLIFOS:
+GlyphAtlas *glyph_atlas_get(SDL_Renderer *render, TTF_Font *font, SDL_Color color);
+static bool glyph_atlas_add_page(GlyphAtlas *atlas);
+static bool glyph_atlas_place(GlyphAtlas *atlas, int w, int h, SDL_Rect *rect);
+int glyph_atlas_glyph(GlyphAtlas *atlas, const char *utf8_char);
+SDL_Texture *glyph_atlas_texture(GlyphAtlas *atlas, int page);
+void glyph_atlas_clear(void);
+void glyph_atlas_measure(GlyphAtlas *atlas, const char *utf8_text, int *w, int *h);
+
+// FUNÇÕES DO LOTE DE TEXTO:
+void text_batch_begin(TextBatch *batch, GlyphAtlas *atlas);
+void text_batch_add(TextBatch *batch, const Glyph *glyph, int x, int y);
+void text_batch_string(TextBatch *batch, const char *utf8_text, int x, int y);
+void text_batch_flush(SDL_Renderer *render, TextBatch *batch);
+void text_batch_free(TextBatch *batch);
+
+// FUNÇÕES DO TEXTO DE HUD:
+HudText hud_text_create(GlyphAtlas *atlas, const char *format, int value);
+void hud_text_set(HudText *hud, int value);
+static void hud_text_compose(HudText *hud);
+void hud_text_render(SDL_Renderer *render, HudText *hud);
+
+// FUNÇÕES DO CACHE DE CAMADAS:
+void layer_cache_begin(LayerCache *cache);
+void layer_cache_add(LayerCache *cache, Sprite *sprite, const SDL_Rect *dst);
+static bool layer_cache_changed(LayerCache *cache);
+void layer_cache_draw(SDL_Renderer *render, LayerCache *cache);
+void layer_cache_invalidate(LayerCache *cache);
+
+// FUNÇÕES DO RENDERIZADOR DE RETÂNGULOS SUJOS:
+void dirty_damage(DirtyRenderer *dirty, const SDL_Rect *rect);
+void dirty_track(DirtyRenderer *dirty, int slot, Sprite *sprite, const SDL_Rect *rect);
+bool dirty_begin(SDL_Renderer *render, DirtyRenderer *dirty, int screen);
+void dirty_clear(SDL_Renderer *render, DirtyRenderer *dirty);
+void dirty_end(SDL_Renderer *render, DirtyRenderer *dirty);
+void dirty_invalidate(DirtyRenderer *dirty);
+
+// FUNÇÕES DA FILA DE DESENHO:
+void render_queue_begin(bool discard);
+void render_queue_layer(int layer);
+void render_queue_depth(int depth);
+void render_queue_group_begin(void);
+void render_queue_group_end(void);
+static RenderCommand *render_queue_push(int type, SDL_Texture *texture);
+void render_queue_copy(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, const SDL_FRect *from, double angle, SDL_RendererFlip flip, Uint8 alpha);
+static RenderTrack *render_queue_find_track(const void *id);
+static void render_queue_prune_tracks(void);
+static bool render_queue_track(const void *id, const SDL_FRect *dst, SDL_FRect *from);
+void render_queue_forget(const void *id);
+void render_queue_set_state(int state);
+void render_set_color(SDL_Renderer *render, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void render_set_blend(SDL_Renderer *render, SDL_BlendMode blend);
+void render_fill_rect(SDL_Renderer *render, const SDL_Rect *rect);
+void render_fill_rects(SDL_Renderer *render, const SDL_Rect *rects, int count);
+void render_clear(SDL_Renderer *render);
+void render_geometry(SDL_Renderer *render, SDL_Texture *texture, const SDL_Vertex *vertices, int quad_count);
+static void render_queue_submit_geometry(SDL_Renderer *render, SDL_Texture *texture, int first_vertex, int quad_count);
+static void render_queue_apply(SDL_Renderer *render, SDL_Color color, SDL_BlendMode blend);
+int render_command_cmp(const void *pa, const void *pb);
+static void render_queue_submit(SDL_Renderer *render, int first, int last);
+void render_queue_flush(SDL_Renderer *render);
+bool render_queue_replay(SDL_Renderer *render);
+void render_queue_free(void);
+int render_queue_overlay(SDL_Renderer *render, GlyphAtlas *atlas, int x, int y);
+
+// FUNÇÕES DO RELÓGIO DA SIMULAÇÃO:
+int sim_clock_advance(SimClock *clock, double elapsed);
+
+// FUNÇÕES DO HUD DE DESEMPENHO:
+void perf_mark(PerfHud *perf);
+void perf_phase(PerfHud *perf, int phase);
+void perf_tick_end(PerfHud *perf, int state);
+void perf_frame_end(PerfHud *perf, int state, bool replay);
+static double perf_average_ms(const PerfHud *perf, int state, int phase);
+int double_cmp(const void *pa, const void *pb);
+static double perf_percentile(const double *sorted, int count, double percentile);
+int perf_overlay(SDL_Renderer *render, GlyphAtlas *atlas, int x, int y);
+
+// FUNÇÕES DE TRACE:
+void trace_init(bool enabled, bool dump_on_exit);
+static TraceRing *trace_ring(void);
+static bool trace_ring_events(TraceRing *ring);
+void trace_name_thread(const char *name);
+Uint64 trace_begin(void);
+void trace_end(const char *name, Uint64 start);
+void trace_scope_end(TraceScope *scope);
+bool trace_dump(const char *path);
+void trace_dump_next(void);
+void trace_shutdown(void);
+
+// FUNÇÕES DOS CONTADORES DE HARDWARE:
+void counters_init(HardwareCounters *counters);
+static bool counters_read(HardwareCounters *counters, CounterMark *mark);
+void counters_begin(HardwareCounters *counters, Uint64 start);
+void counters_end(HardwareCounters *counters, const char *name, Uint64 start);
+void counters_report(HardwareCounters *counters);
+void counters_shutdown(HardwareCounters *counters);
+
+// FUNÇÕES DO PERFILADOR POR AMOSTRAGEM:
+void sampler_init(Sampler *sampler, const GameState *flags);
+static Uint64 sampler_hash(const Sample *sample);
+static bool sampler_same(const Sample *a, const Sample *b);
+static bool sampler_grow(Sampler *sampler);
+void sampler_drain(Sampler *sampler);
+static int folded_line_cmp(const void *a, const void *b);
+static void sampler_write_frame(FILE *file, const char *symbol);
+void sampler_shutdown(Sampler *sampler);
+
+// FUNÇÕES DO GRAVADOR DE VOO:
+void flight_record(FlightRecorder *flight, const GameState *flags);
+static void flight_write_frame(FILE *file, const FlightFrame *frame);
+bool flight_dump(FlightRecorder *flight, const FlightFrame *trigger);
+static int flight_writer(void *data);
+void flight_shutdown(FlightRecorder *flight);
+
+// FUNÇÕES DA EXECUÇÃO SEM TELA:
+void headless_prepare(Headless *headless);
+bool headless_frame(Headless *headless);
+void headless_report(Headless *headless);
+
+// FUNÇÕES DO RITMO DE QUADROS:
+void frame_pacer_init(FramePacer *pacer, SDL_Renderer *render, SDL_Window *window);
+double frame_pacer_frame(FramePacer *pacer);
+void frame_pacer_wait(FramePacer *pacer);
+void frame_pacer_idle(FramePacer *pacer, double seconds);
+
+// FUNÇÕES DO PACOTE DE ASSETS:
+bool pack_open(const char *path);
+static const PackEntry *pack_find(const char *path);
+static int pack_close_owned(SDL_RWops *rw);
+SDL_RWops *asset_open_rw(const char *path);
+static char *asset_read_text(const char *path);
+static size_t asset_size(const char *path);
+static void asset_list(const char *dir, const char *ext, char ***paths, int *count, int *capacity);
+void pack_close(void);
+bool build_pack(const char *assets_dir, const char *out_path);
+
+// FUNÇÕES DO CACHE DE ASSETS:
+static void *cache_find(AssetCache *cache, const char *key);
+static void *cache_find_content(AssetCache *cache, Uint64 content_hash, SDL_Surface *surface);
+static void cache_index(AssetCache *cache, int index);
+static void cache_insert(AssetCache *cache, const char *key, Uint64 content_hash, void *handle);
+static int cache_remove_handle(AssetCache *cache, void *handle);
+static void cache_clear(AssetCache *cache);
+static Uint64 hash_surface(SDL_Surface *surface);
+static bool surface_same_content(SDL_Surface *a, const char *path);
+
+// FUNÇÕES DO CARREGADOR PARALELO:
+void loader_start(int thread_count);
+static LoadJob *loader_wait(const char *path);
+static SDL_Surface *loader_surface(const char *path, Uint64 *content_hash);
+static Mix_Chunk *loader_chunk(const char *path);
+static int loader_worker(void *data);
+void loader_finish(void);
+
+// FUNÇÕES DO PERFIL DE INICIALIZAÇÃO:
+void profile_start(bool enabled, const char *benchmark);
+static void profile_record(const char *name, const char *category, Uint64 start, size_t bytes);
+static void profile_drop_file_cache(void);
+static void trace_write_string(FILE *file, const char *s);
+void profile_finish(void);
+
+// FUNÇÕES DE RESIDÊNCIA:
+static Uint32 residency_states(const char *path);
+static void residency_track_sprite(Sprite *sprite, const char *source_path, const char *dir);
+static bool png_size(const char *path, int *w, int *h);
+static Uint32 atlas_page_states(int page);
+static bool residency_deferred(Uint32 states);
+static Sprite *residency_defer_sprite(const char *source_path, const char *dir, Uint32 states, SDL_Rect src);
+static bool residency_reserve_texture(void);
+static bool residency_reserve_sound(void);
+static Mix_Chunk *residency_defer_chunk(const char *dir, int volume, Uint32 states);
+static void residency_track_chunk(Mix_Chunk *chunk, const char *dir, int volume);
+void residency_track_sounds(Sound *sounds, int count);
+static void residency_install_texture(int index, SDL_Texture *texture);
+static void residency_install_sound(int index, Mix_Chunk *chunk);
+static void residency_upload(SDL_Renderer *render, int index, SDL_Surface *surface);
+static int residency_load(SDL_Renderer *render, int state);
+static int residency_evict(int state);
+void residency_prefetch(int state);
+static int residency_prefetch_worker(void *data);
+static void residency_collect_prefetch(SDL_Renderer *render);
+void residency_update(SDL_Renderer *render, int state);
+static bool residency_fault(SDL_Renderer *render, Sprite *sprite);
+void residency_shutdown(void);
+
 // FUNÇÕES DE GAMEPLAY:
 void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *player_state, int *game_state, double dt, Animation *meneghetti_face, Animation *python_face, Sound *sound, Prop *bubble_speech);
 void reset_dialogue(Text *text);
+void layout_dialogue(Text *text, const char *writing, SDL_Rect box);
+static bool layout_page_break(TextLayout *layout, int *y, int line_height);
+static void layout_ellipsis(TextLayout *layout, GlyphAtlas *atlas, int byte);
 void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *player_health, int damage, int attack_index, bool *ivulnerable, Projectile **props, double dt, double turn_timer, Sound *sound, bool clear);
 void sprite_update(Character *scenario, Character *player, Animation *animation, double dt, SDL_Rect boxes[], SDL_Rect surfaces[], double *anim_timer, double anim_interval, Sound *sound);
-SDL_Texture *animate_sprite(Animation *anim, double dt, double cooldown, bool blink);
+Sprite *animate_sprite(Animation *anim, double dt, double cooldown, bool blink);
 bool rects_intersect(SDL_Rect *a, SDL_Rect *b, SDL_FRect *c);
 bool check_collision(SDL_Rect *player, SDL_Rect boxes[], int box_count);
 static int surface_to_sound_index(int surface_index);
@@ -212,12 +1203,25 @@ void update_reflection(Character *original, Character* reflection, Animation *an
 void organize_items(Prop *text_items);
 
 // FUNÇÕES DE REGISTRO DE OBJETOS:
-static void track_texture(SDL_Texture *texture);
-static bool already_tracked_texture(SDL_Texture *texture);
-static void track_chunk(Mix_Chunk *chunk);
-static bool already_tracked_chunk(Mix_Chunk *chunk);
-static void track_font(TTF_Font *font);
-static bool already_tracked_font(TTF_Font *font);
+static Uint32 resource_slot_hash(const void *pointer);
+static int resource_find_index(const void *pointer);
+static void resource_grow_index(void);
+static void resource_describe(ResourceSlot *entry);
+void resource_account(void *pointer, size_t bytes);
+void resource_name(void *pointer, const char *name);
+static void resource_mark_state(void);
+static const char *resource_state_name(int state);
+void resource_set_state(int state);
+int resource_overlay(SDL_Renderer *render, GlyphAtlas *atlas, int x, int y);
+void resource_report(const char *path);
+static ResourceHandle resource_register(void *pointer, int kind);
+void *resource_get(ResourceHandle handle);
+void resource_retain(void *pointer);
+static void resource_destroy(void *pointer, int kind);
+bool resource_release(void *pointer);
+ResourceStats resource_stats(void);
+void resource_release_all(void);
+static void track_sprite(Sprite *sprite);
 
 // FUNÇÕES DE LIMPEZA:
 void game_cleanup(Game *game, int exit_status);
@@ -226,37 +1230,215 @@ void clean_tracked_resources(void);
 // FUNÇÕES AUXILIARES:
 static int utf8_charlen(const char *s);
 static int utf8_copy_char(const char *s, char *out);
-int renderitem_cmp(const void *pa, const void *pb);
+static Uint32 utf8_decode(const char *s);
+static Uint32 hash_string(const char *s);
+static Uint64 hash_bytes(Uint64 hash, const void *data, size_t size);
+static Uint64 hash_words(Uint64 hash, const void *data, size_t size);
+static void collect_files(const char *dir, const char *ext, char ***paths, int *count, int *capacity);
+static bool make_directory(const char *dir);
+int atlas_source_cmp(const void *pa, const void *pb);
+int profile_event_cmp(const void *pa, const void *pb);
+int load_job_cmp(const void *pa, const void *pb);
 int randint(int min, int max);
 int choice(int count, ...);
 
-// RASTREADORES GLOBAIS:
-static SDL_Texture **guarded_textures = NULL;
-static int guarded_textures_count = 0;
-static int guarded_textures_capacity = 0;
+// REGISTRO GLOBAL DE RECURSOS:
+static ResourceRegistry registry = {.free_head = -1, .state = RESOURCE_STATE_STARTUP};
 
-static Mix_Chunk **guarded_chunks = NULL;
-static int guarded_chunks_count = 0;
-static int guarded_chunks_capacity = 0;
+// NOMES USADOS NO OVERLAY E NOS RELATÓRIOS:
+static const char *resource_kind_names[RESOURCE_KIND_COUNT] = {"texture", "chunk", "font", "music"};
+static const char *game_state_names[GAME_STATE_COUNT] = {"TITLE_SCREEN", "CUTSCENE", "OPEN_WORLD", "BATTLE_SCREEN", "DEATH_SCREEN", "FINAL_SCREEN"};
 
-static TTF_Font **guarded_fonts = NULL;
-static int guarded_fonts_count = 0;
-static int guarded_fonts_capacity = 0;
+// RASTREADORES GLOBAIS:
+static Sprite **guarded_sprites = NULL;
+static int guarded_sprites_count = 0;
+static int guarded_sprites_capacity = 0;
+static int sprite_failures = 0;
+
+// ATLAS CARREGADO:
+static SDL_Texture **atlas_pages = NULL;
+static char **atlas_page_paths = NULL;
+static int atlas_page_count = 0;
+static AtlasEntry *atlas_entries = NULL;
+static int atlas_entry_count = 0;
+static int *atlas_slots = NULL;
+static int atlas_slot_capacity = 0;
+
+// PACOTE MAPEADO:
+static Uint8 *pack_data = NULL;
+static size_t pack_size = 0;
+static const PackEntry *pack_entries = NULL;
+static int pack_entry_count = 0;
+static int *pack_slots = NULL;
+static int pack_slot_capacity = 0;
+
+// CACHES DE TEXTURAS E FONTES:
+static AssetCache texture_cache = {0};
+static AssetCache font_cache = {0};
+
+// ATLAS DE GLIFOS ATIVOS:
+static GlyphAtlas **glyph_atlases = NULL;
+static int glyph_atlas_count = 0;
+static int glyph_atlas_capacity = 0;
+
+// LOTE DE TEXTO COMPARTILHADO E SEUS CONTADORES:
+static TextBatch text_batch = {0};
+static TextStats text_stats = {0};
+
+// FUNDO DO MUNDO ABERTO EM CACHE:
+static LayerCache parallax_cache = {0};
+
+// TELAS ESTÁTICAS EM MODO DE RETÂNGULOS SUJOS (--dirty-rects):
+static DirtyRenderer dirty_renderer = {.screen = -1};
+
+// RECORTE CONTRA A TELA:
+static CullStats cull_stats = {0};
+
+// FILA DE DESENHO DO QUADRO:
+static RenderQueue render_queue = {0};
+
+// RELÓGIO DA SIMULAÇÃO:
+static SimClock sim_clock = {0};
+
+// RITMO DE QUADROS (--fps N, --no-vsync):
+static FramePacer frame_pacer = {.vsync_requested = true, .target_rate = -1};
+
+// EXECUÇÃO SEM TELA (--headless [--frames N]):
+static Headless headless = {0};
+
+// HUD DE DESEMPENHO (F7):
+static PerfHud perf_hud = {0};
+
+// ZONAS DE TRACE:
+static Tracer tracer = {0};
+
+// CONTADORES DE HARDWARE POR ZONA (--perf-counters):
+static HardwareCounters hardware_counters = {0};
+static const char *counter_names[COUNTER_COUNT] = {"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+
+// PERFILADOR POR AMOSTRAGEM (--sample-profile, --sample-rate HZ):
+static Sampler sampler = {0};
+
+// GRAVADOR DE VOO (--frame-budget MS, 0 desliga os despejos):
+static FlightRecorder flight_recorder = {.budget = FLIGHT_BUDGET_MS / 1000.0};
+static const SDL_Scancode flight_keys[FLIGHT_KEY_COUNT] = {SDL_SCANCODE_W, SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_D, SDL_SCANCODE_E,
+                                                           SDL_SCANCODE_RETURN, SDL_SCANCODE_SPACE, SDL_SCANCODE_ESCAPE, SDL_SCANCODE_F7, SDL_SCANCODE_F8};
+
+// ESTATÍSTICAS NO TERMINAL (--stats):
+static bool print_stats = false;
+
+// GRUPOS DE RESIDÊNCIA (o que não casa com nenhuma regra fica residente sempre):
+static const ResidencyRule residency_rules[] = {
+    {"assets/sprites/misc/story-frame", STATE_BIT(CUTSCENE)},
+    {"assets/sprites/scenario/", STATE_BIT(OPEN_WORLD)},
+    {"assets/sprites/battle/", STATE_BIT(BATTLE_SCREEN) | STATE_BIT(DEATH_SCREEN)},
+    {"assets/sprites/hud/button-", STATE_BIT(BATTLE_SCREEN)},
+    {"assets/sounds/sound_effects/battle-sounds/", STATE_BIT(BATTLE_SCREEN) | STATE_BIT(DEATH_SCREEN)},
+};
+static Residency residency = {.state = -1, .prefetch_state = -1, .startup_state = CUTSCENE};
+
+// PERFIL ATIVO:
+static StartupProfiler profiler = {0};
+
+// CARREGADOR ATIVO:
+static AssetLoader loader = {0};
 
 int main(int argc, char* argv[]) {
     srand(time(NULL));
-    
-    (void) argc;
-    (void) argv;
 
+    if (argc > 1 && strcmp(argv[1], "--build-atlas") == 0) {
+        return build_atlas(SPRITES_DIR, ATLAS_DIR) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    if (argc > 1 && strcmp(argv[1], "--build-pack") == 0) {
+        return build_pack(ASSETS_DIR, PACK_PATH) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    // OPÇÕES DE CARREGAMENTO (--serial-load mantém o caminho antigo para comparação):
+    // --benchmark-startup cold|warm sai depois do carregamento e acrescenta uma linha em startup-bench.csv.
+    int load_threads = SDL_GetCPUCount();
+    bool profile_startup = false;
+    bool trace_on_exit = false;
+    const char *startup_benchmark = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--serial-load") == 0) {
+            load_threads = 0;
+        }
+        else if (strcmp(argv[i], "--load-threads") == 0 && i + 1 < argc) {
+            load_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--profile-startup") == 0) {
+            profile_startup = true;
+        }
+        else if (strcmp(argv[i], "--benchmark-startup") == 0 && i + 1 < argc) {
+            const char *mode = argv[++i];
+            if (strcmp(mode, "cold") != 0 && strcmp(mode, "warm") != 0) {
+                fprintf(stderr, "Error: --benchmark-startup expects 'cold' or 'warm', got '%s'\n", mode);
+                return EXIT_FAILURE;
+            }
+            startup_benchmark = strcmp(mode, "cold") == 0 ? "cold" : "warm";
+        }
+        else if (strcmp(argv[i], "--dirty-rects") == 0) {
+            dirty_renderer.enabled = true;
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            frame_pacer.target_rate = SDL_max(atoi(argv[++i]), 0);
+        }
+        else if (strcmp(argv[i], "--no-vsync") == 0) {
+            frame_pacer.vsync_requested = false;
+        }
+        else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+            flight_recorder.budget = SDL_max(atof(argv[++i]), 0.0) / 1000.0;
+        }
+        else if (strcmp(argv[i], "--perf-counters") == 0) {
+            hardware_counters.requested = true;
+        }
+        else if (strcmp(argv[i], "--perf-counters-kernel") == 0) {
+            hardware_counters.requested = true;
+            hardware_counters.kernel = true;
+        }
+        else if (strcmp(argv[i], "--sample-profile") == 0) {
+            if (sampler.rate <= 0) sampler.rate = SAMPLER_DEFAULT_RATE;
+        }
+        else if (strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc) {
+            sampler.rate = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--trace") == 0) {
+            trace_on_exit = true;
+        }
+        else if (strcmp(argv[i], "--stats") == 0) {
+            print_stats = true;
+        }
+        else if (strcmp(argv[i], "--headless") == 0) {
+            headless.enabled = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            headless.frame_limit = atoi(argv[++i]);
+        }
+    }
+    profile_start(profile_startup, startup_benchmark);
+    trace_init(trace_on_exit || hardware_counters.requested, trace_on_exit);
+    counters_init(&hardware_counters);
+    headless_prepare(&headless);
+    
     Game game = {
         .renderer = NULL,
         .window = NULL,
     };
 
+    Uint64 phase = SDL_GetPerformanceCounter();
+    // Pacote ausente ou corrompido não impede o jogo: os assets vêm dos arquivos soltos.
+    (void)pack_open(PACK_PATH);
+    profile_record(PACK_PATH, "load", phase, pack_size);
+
     if (sdl_initialize(&game))
         game_cleanup(&game, EXIT_FAILURE);
 
+    phase = SDL_GetPerformanceCounter();
+    // Mesmo fallback do pacote: sem atlas válido, os sprites são carregados um a um.
+    (void)atlas_load(ATLAS_INDEX_PATH);
+    profile_record(ATLAS_INDEX_PATH, "load", phase, 0);
+    loader_start(load_threads);
+
     SDL_bool running = SDL_TRUE;
     SDL_Event event;
 
@@ -279,23 +1461,23 @@ int main(int argc, char* argv[]) {
     // PACOTES DE ANIMAÇÃO:
     Animation anim_pack[DIR_COUNT];
     anim_pack[UP].count = 3;
-    anim_pack[UP].frames = malloc(sizeof(SDL_Texture*) * anim_pack[UP].count);
-    anim_pack[UP].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-back.png");
-    anim_pack[UP].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-back-1.png");
-    anim_pack[UP].frames[2] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-back-2.png");
+    anim_pack[UP].frames = malloc(sizeof(Sprite*) * anim_pack[UP].count);
+    anim_pack[UP].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-back.png");
+    anim_pack[UP].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-back-1.png");
+    anim_pack[UP].frames[2] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-back-2.png");
     anim_pack[DOWN].count = 3;
-    anim_pack[DOWN].frames = malloc(sizeof(SDL_Texture*) * anim_pack[DOWN].count);
-    anim_pack[DOWN].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-front.png");
-    anim_pack[DOWN].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-front-1.png");
-    anim_pack[DOWN].frames[2] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-front-2.png");
+    anim_pack[DOWN].frames = malloc(sizeof(Sprite*) * anim_pack[DOWN].count);
+    anim_pack[DOWN].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-front.png");
+    anim_pack[DOWN].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-front-1.png");
+    anim_pack[DOWN].frames[2] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-front-2.png");
     anim_pack[LEFT].count = 2;
-    anim_pack[LEFT].frames = malloc(sizeof(SDL_Texture*) * anim_pack[LEFT].count);
-    anim_pack[LEFT].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-left.png");
-    anim_pack[LEFT].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-left-1.png");
+    anim_pack[LEFT].frames = malloc(sizeof(Sprite*) * anim_pack[LEFT].count);
+    anim_pack[LEFT].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-left.png");
+    anim_pack[LEFT].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-left-1.png");
     anim_pack[RIGHT].count = 2;
-    anim_pack[RIGHT].frames = malloc(sizeof(SDL_Texture*) * anim_pack[RIGHT].count);
-    anim_pack[RIGHT].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-right.png");
-    anim_pack[RIGHT].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-right-1.png");
+    anim_pack[RIGHT].frames = malloc(sizeof(Sprite*) * anim_pack[RIGHT].count);
+    anim_pack[RIGHT].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-right.png");
+    anim_pack[RIGHT].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-right-1.png");
     for (int i = 0; i < DIR_COUNT; i++) {
         for (int n = 0; n < anim_pack[i].count; n++) {
             if (!anim_pack[i].frames[n]) {
@@ -307,23 +1489,23 @@ int main(int argc, char* argv[]) {
 
     Animation anim_pack_reflex[DIR_COUNT];
     anim_pack_reflex[UP].count = 3;
-    anim_pack_reflex[UP].frames = malloc(sizeof(SDL_Texture*) * anim_pack_reflex[UP].count);
-    anim_pack_reflex[UP].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-back.png");
-    anim_pack_reflex[UP].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-back-1.png");
-    anim_pack_reflex[UP].frames[2] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-back-2.png");
+    anim_pack_reflex[UP].frames = malloc(sizeof(Sprite*) * anim_pack_reflex[UP].count);
+    anim_pack_reflex[UP].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-back.png");
+    anim_pack_reflex[UP].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-back-1.png");
+    anim_pack_reflex[UP].frames[2] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-back-2.png");
     anim_pack_reflex[DOWN].count = 3;
-    anim_pack_reflex[DOWN].frames = malloc(sizeof(SDL_Texture*) * anim_pack_reflex[DOWN].count);
-    anim_pack_reflex[DOWN].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-front.png");
-    anim_pack_reflex[DOWN].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-front-1.png");
-    anim_pack_reflex[DOWN].frames[2] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-front-2.png");
+    anim_pack_reflex[DOWN].frames = malloc(sizeof(Sprite*) * anim_pack_reflex[DOWN].count);
+    anim_pack_reflex[DOWN].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-front.png");
+    anim_pack_reflex[DOWN].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-front-1.png");
+    anim_pack_reflex[DOWN].frames[2] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-front-2.png");
     anim_pack_reflex[LEFT].count = 2;
-    anim_pack_reflex[LEFT].frames = malloc(sizeof(SDL_Texture*) * anim_pack_reflex[LEFT].count);
-    anim_pack_reflex[LEFT].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-left.png");
-    anim_pack_reflex[LEFT].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-left-1.png");
+    anim_pack_reflex[LEFT].frames = malloc(sizeof(Sprite*) * anim_pack_reflex[LEFT].count);
+    anim_pack_reflex[LEFT].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-left.png");
+    anim_pack_reflex[LEFT].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-left-1.png");
     anim_pack_reflex[RIGHT].count = 2;
-    anim_pack_reflex[RIGHT].frames = malloc(sizeof(SDL_Texture*) * anim_pack_reflex[RIGHT].count);
-    anim_pack_reflex[RIGHT].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-right.png");
-    anim_pack_reflex[RIGHT].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-right-1.png");
+    anim_pack_reflex[RIGHT].frames = malloc(sizeof(Sprite*) * anim_pack_reflex[RIGHT].count);
+    anim_pack_reflex[RIGHT].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-right.png");
+    anim_pack_reflex[RIGHT].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-right-1.png");
     for (int i = 0; i < DIR_COUNT; i++) {
         for (int n = 0; n < anim_pack_reflex[i].count; n++) {
             if (!anim_pack_reflex[i].frames[n]) {
@@ -331,41 +1513,41 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
             else {
-                SDL_SetTextureAlphaMod(anim_pack_reflex[i].frames[n], 70);
+                sprite_set_alpha(anim_pack_reflex[i].frames[n], 70);
             }
         }
     }
 
     Animation mr_python_animation[DIR_COUNT];
     mr_python_animation[UP].count = 1;
-    mr_python_animation[UP].frames = malloc(sizeof(SDL_Texture*) * mr_python_animation[UP].count);
-    mr_python_animation[UP].frames[0] = create_texture(game.renderer, "assets/sprites/characters/mr-python-back-1.png");
+    mr_python_animation[UP].frames = malloc(sizeof(Sprite*) * mr_python_animation[UP].count);
+    mr_python_animation[UP].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/mr-python-back-1.png");
     mr_python_animation[DOWN].count = 2;
-    mr_python_animation[DOWN].frames = malloc(sizeof(SDL_Texture*) * mr_python_animation[DOWN].count);
-    mr_python_animation[DOWN].frames[0] = create_texture(game.renderer, "assets/sprites/characters/mr-python-front-1.png");
-    mr_python_animation[DOWN].frames[1] = create_texture(game.renderer, "assets/sprites/characters/mr-python-front-2.png");
+    mr_python_animation[DOWN].frames = malloc(sizeof(Sprite*) * mr_python_animation[DOWN].count);
+    mr_python_animation[DOWN].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/mr-python-front-1.png");
+    mr_python_animation[DOWN].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/mr-python-front-2.png");
     mr_python_animation[LEFT].count = 2;
-    mr_python_animation[LEFT].frames = malloc(sizeof(SDL_Texture*) * mr_python_animation[LEFT].count);
-    mr_python_animation[LEFT].frames[0] = create_texture(game.renderer, "assets/sprites/characters/mr-python-left-1.png");
-    mr_python_animation[LEFT].frames[1] = create_texture(game.renderer, "assets/sprites/characters/mr-python-left-2.png");
+    mr_python_animation[LEFT].frames = malloc(sizeof(Sprite*) * mr_python_animation[LEFT].count);
+    mr_python_animation[LEFT].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/mr-python-left-1.png");
+    mr_python_animation[LEFT].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/mr-python-left-2.png");
     mr_python_animation[RIGHT].count = 2;
-    mr_python_animation[RIGHT].frames = malloc(sizeof(SDL_Texture*) * mr_python_animation[RIGHT].count);
-    mr_python_animation[RIGHT].frames[0] = create_texture(game.renderer, "assets/sprites/characters/mr-python-right-1.png");
-    mr_python_animation[RIGHT].frames[1] = create_texture(game.renderer, "assets/sprites/characters/mr-python-right-2.png");
+    mr_python_animation[RIGHT].frames = malloc(sizeof(Sprite*) * mr_python_animation[RIGHT].count);
+    mr_python_animation[RIGHT].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/mr-python-right-1.png");
+    mr_python_animation[RIGHT].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/mr-python-right-2.png");
 
     Animation meneghetti_dialogue[3];
     meneghetti_dialogue[0].count = 2;
-    meneghetti_dialogue[0].frames = malloc(sizeof(SDL_Texture*) * meneghetti_dialogue[0].count);
-    meneghetti_dialogue[0].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-dialogue-1.png");
-    meneghetti_dialogue[0].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-dialogue-2.png");
+    meneghetti_dialogue[0].frames = malloc(sizeof(Sprite*) * meneghetti_dialogue[0].count);
+    meneghetti_dialogue[0].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-dialogue-1.png");
+    meneghetti_dialogue[0].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-dialogue-2.png");
     meneghetti_dialogue[1].count = 2;
-    meneghetti_dialogue[1].frames = malloc(sizeof(SDL_Texture*) * meneghetti_dialogue[1].count);
-    meneghetti_dialogue[1].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-dialogue-angry-1.png");
-    meneghetti_dialogue[1].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-dialogue-angry-2.png");
+    meneghetti_dialogue[1].frames = malloc(sizeof(Sprite*) * meneghetti_dialogue[1].count);
+    meneghetti_dialogue[1].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-dialogue-angry-1.png");
+    meneghetti_dialogue[1].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-dialogue-angry-2.png");
     meneghetti_dialogue[2].count = 2;
-    meneghetti_dialogue[2].frames = malloc(sizeof(SDL_Texture*) * meneghetti_dialogue[2].count);
-    meneghetti_dialogue[2].frames[0] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-dialogue-sad-1.png");
-    meneghetti_dialogue[2].frames[1] = create_texture(game.renderer, "assets/sprites/characters/meneghetti-dialogue-sad-2.png");
+    meneghetti_dialogue[2].frames = malloc(sizeof(Sprite*) * meneghetti_dialogue[2].count);
+    meneghetti_dialogue[2].frames[0] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-dialogue-sad-1.png");
+    meneghetti_dialogue[2].frames[1] = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-dialogue-sad-2.png");
     for (int i = 0; i < 2; i++) {
         for (int n = 0; n < meneghetti_dialogue[i].count; n++) {
             if (!meneghetti_dialogue[i].frames[n]) {
@@ -376,7 +1558,7 @@ int main(int argc, char* argv[]) {
     }
 
     Animation python_dialogue = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/characters/python-dialogue-1.png"), create_texture(game.renderer, "assets/sprites/characters/python-dialogue-2.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/characters/python-dialogue-1.png"), create_sprite(game.renderer, "assets/sprites/characters/python-dialogue-2.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 2
@@ -387,99 +1569,99 @@ int main(int argc, char* argv[]) {
     }
 
     Animation title_text_anim = {
-        .frames = (SDL_Texture*[]){create_text(game.renderer, "APERTE ENTER PARA COMEÇAR", title_text_font, gray), NULL},
+        .frames = (Sprite*[]){sprite_from_texture(create_text(game.renderer, "APERTE ENTER PARA COMEÇAR", title_text_font, gray)), NULL},
         .timer = 0.0,
         .counter = 0,
         .count = 2
     };
 
     Animation lake_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/scenario/lake-1.png"), create_texture(game.renderer, "assets/sprites/scenario/lake-2.png"), create_texture(game.renderer, "assets/sprites/scenario/lake-3.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/scenario/lake-1.png"), create_sprite(game.renderer, "assets/sprites/scenario/lake-2.png"), create_sprite(game.renderer, "assets/sprites/scenario/lake-3.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 3
     };
 
     Animation ocean_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/scenario/ocean-1.png"), create_texture(game.renderer, "assets/sprites/scenario/ocean-2.png"), create_texture(game.renderer, "assets/sprites/scenario/ocean-3.png"), create_texture(game.renderer, "assets/sprites/scenario/ocean-4.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/scenario/ocean-1.png"), create_sprite(game.renderer, "assets/sprites/scenario/ocean-2.png"), create_sprite(game.renderer, "assets/sprites/scenario/ocean-3.png"), create_sprite(game.renderer, "assets/sprites/scenario/ocean-4.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 4
     };
 
     Animation sky_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/scenario/sky-1.png"), create_texture(game.renderer, "assets/sprites/scenario/sky-2.png"), create_texture(game.renderer, "assets/sprites/scenario/sky-3.png"), create_texture(game.renderer, "assets/sprites/scenario/sky-4.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/scenario/sky-1.png"), create_sprite(game.renderer, "assets/sprites/scenario/sky-2.png"), create_sprite(game.renderer, "assets/sprites/scenario/sky-3.png"), create_sprite(game.renderer, "assets/sprites/scenario/sky-4.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 4
     };
 
     Animation sun_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/scenario/sun-1.png"), create_texture(game.renderer, "assets/sprites/scenario/sun-2.png"), create_texture(game.renderer, "assets/sprites/scenario/sun-3.png"), create_texture(game.renderer, "assets/sprites/scenario/sun-4.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/scenario/sun-1.png"), create_sprite(game.renderer, "assets/sprites/scenario/sun-2.png"), create_sprite(game.renderer, "assets/sprites/scenario/sun-3.png"), create_sprite(game.renderer, "assets/sprites/scenario/sun-4.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 4
     };
 
     Animation soul_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/soul.png"), NULL},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/soul.png"), NULL},
         .timer = 0.0,
         .counter = 0,
         .count = 2
     };
 
     Animation bar_attack_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/bar-attack-2.png"), create_texture(game.renderer, "assets/sprites/battle/bar-attack-1.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/bar-attack-2.png"), create_sprite(game.renderer, "assets/sprites/battle/bar-attack-1.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 2
     };
 
     Animation slash_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/slash-1.png"), create_texture(game.renderer, "assets/sprites/battle/slash-2.png"), create_texture(game.renderer, "assets/sprites/battle/slash-3.png"), create_texture(game.renderer, "assets/sprites/battle/slash-4.png"), create_texture(game.renderer, "assets/sprites/battle/slash-5.png"), create_texture(game.renderer, "assets/sprites/battle/slash-6.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/slash-1.png"), create_sprite(game.renderer, "assets/sprites/battle/slash-2.png"), create_sprite(game.renderer, "assets/sprites/battle/slash-3.png"), create_sprite(game.renderer, "assets/sprites/battle/slash-4.png"), create_sprite(game.renderer, "assets/sprites/battle/slash-5.png"), create_sprite(game.renderer, "assets/sprites/battle/slash-6.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 6
     };
 
     Animation python_head_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-head-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-head-2.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/python-head-1.png"), create_sprite(game.renderer, "assets/sprites/battle/python-head-2.png")},
         .count = 2
     };
 
     Animation python_arms_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-arms.png"), create_texture(game.renderer, "assets/sprites/battle/python-arms-hurt.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/python-arms.png"), create_sprite(game.renderer, "assets/sprites/battle/python-arms-hurt.png")},
         .count = 2
     };
     
     Animation python_legs_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-legs.png"), create_texture(game.renderer, "assets/sprites/battle/python-legs-hurt.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/python-legs.png"), create_sprite(game.renderer, "assets/sprites/battle/python-legs-hurt.png")},
         .count = 2
     };
 
     Animation python_mother_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-2.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/python-1.png"), create_sprite(game.renderer, "assets/sprites/battle/python-2.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 2
     };
 
     Animation python_baby_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-baby-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-baby-2.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/python-baby-1.png"), create_sprite(game.renderer, "assets/sprites/battle/python-baby-2.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 2
     };
 
     Animation python_barrier_left_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-barrier-left-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-barrier-left-2.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/python-barrier-left-1.png"), create_sprite(game.renderer, "assets/sprites/battle/python-barrier-left-2.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 2
     };
 
     Animation python_barrier_right_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-barrier-right-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-barrier-right-2.png")},
+        .frames = (Sprite*[]){create_sprite(game.renderer, "assets/sprites/battle/python-barrier-right-1.png"), create_sprite(game.renderer, "assets/sprites/battle/python-barrier-right-2.png")},
         .timer = 0.0,
         .counter = 0,
         .count = 2
@@ -487,7 +1669,7 @@ int main(int argc, char* argv[]) {
 
     // OBJETOS:
     Character meneghetti = {
-        .texture = anim_pack[DOWN].frames[0],
+        .sprite = anim_pack[DOWN].frames[0],
         .collision = {(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) - 16, 19, 32},
         .sprite_vel = 100.0f, // Deve ser par.
         .keystate = SDL_GetKeyboardState(NULL),
@@ -499,307 +1681,285 @@ int main(int argc, char* argv[]) {
     };
 
     Character scenario = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/scenario.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/scenario/scenario.png"),
         .collision = {0, -SCREEN_HEIGHT, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2}
     };
-    if (!scenario.texture) {
+    if (!scenario.sprite) {
         fprintf(stderr, "Error loading scenario: %s\n", SDL_GetError());
         return 1;
     }
 
     Character meneghetti_civic = {
-        .texture = create_texture(game.renderer, "assets/sprites/characters/meneghetti-civic-left.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/characters/meneghetti-civic-left.png"),
         .collision = {scenario.collision.x + scenario.collision.w, scenario.collision.y + 731, 64, 42}
     };
-    if (!meneghetti_civic.texture) {
+    if (!meneghetti_civic.sprite) {
         fprintf(stderr, "Error loading scenario: %s\n", SDL_GetError());
         return 1;
     }
 
     Character mr_python_head = {
-        .texture = python_head_animation.frames[0],
+        .sprite = python_head_animation.frames[0],
         .collision = {(SCREEN_WIDTH / 2) - 102, 25, 204, 204},
         .health = 200,
         .strength = 2
     };
 
     Character meneghetti_reflection = {
-        .texture = anim_pack_reflex[DOWN].frames[0],
+        .sprite = anim_pack_reflex[DOWN].frames[0],
         .facing = DOWN,
         .counters = {0, 0, 0, 0}
     };
 
     // PROPS:
     Prop mr_python_torso = {
-        .texture = create_texture(game.renderer, "assets/sprites/battle/python-torso.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/battle/python-torso.png"),
         .collision = {mr_python_head.collision.x, mr_python_head.collision.y, mr_python_head.collision.w, mr_python_head.collision.h},
     };
 
     Prop mr_python_arms = {
-        .texture = python_arms_animation.frames[0],
+        .sprite = python_arms_animation.frames[0],
         .collision = {mr_python_head.collision.x, mr_python_head.collision.y, mr_python_head.collision.w, mr_python_head.collision.h}
     };
 
     Prop mr_python_legs = {
-        .texture = python_legs_animation.frames[0],
+        .sprite = python_legs_animation.frames[0],
         .collision = {mr_python_head.collision.x, mr_python_head.collision.y, mr_python_head.collision.w, mr_python_head.collision.h}
     };
 
     Prop slash = {
-        .texture = slash_animation.frames[0],
+        .sprite = slash_animation.frames[0],
         .collision = {mr_python_torso.collision.x + (mr_python_torso.collision.w / 2) + 16, mr_python_torso.collision.y + 32, 32, 164},
     };
 
     Prop title = {
-        .texture = create_texture(game.renderer, "assets/sprites/hud/logo-c-tale.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/hud/logo-c-tale.png"),
         .collision = {(SCREEN_WIDTH / 2) - 290, (SCREEN_HEIGHT / 2) - 32, 580, 63}
     };
 
     Prop title_text = {
-        .texture = title_text_anim.frames[0],
+        .sprite = title_text_anim.frames[0],
     };
-    int title_text_width, title_text_height;
-    SDL_QueryTexture(title_text.texture, NULL, NULL, &title_text_width, &title_text_height);
-    title_text.collision = (SDL_Rect){(SCREEN_WIDTH / 2) - (title_text_width / 2), SCREEN_HEIGHT - 100, title_text_width, title_text_height};
+    title_text.collision = (SDL_Rect){(SCREEN_WIDTH / 2) - (title_text.sprite->w / 2), SCREEN_HEIGHT - 100, title_text.sprite->w, title_text.sprite->h};
 
     Prop soul = {
-        .texture = soul_animation.frames[0],
+        .sprite = soul_animation.frames[0],
         .collision = {(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) - 10, 20, 20}
     };
 
     Prop soul_shattered = {
-        .texture = create_texture(game.renderer, "assets/sprites/battle/soul-broken.png")
+        .sprite = create_sprite(game.renderer, "assets/sprites/battle/soul-broken.png")
     };
 
     Prop mr_python = {
-        .texture = mr_python_animation[DOWN].frames[0],
+        .sprite = mr_python_animation[DOWN].frames[0],
         .facing = DOWN
     };
 
     Prop python_van = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/python-van.png")
+        .sprite = create_sprite(game.renderer, "assets/sprites/scenario/python-van.png")
     };
 
     Prop civic = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/civic-left.png")
+        .sprite = create_sprite(game.renderer, "assets/sprites/scenario/civic-left.png")
     };
 
     Prop palm_left = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/palm-head-left.png")
+        .sprite = create_sprite(game.renderer, "assets/sprites/scenario/palm-head-left.png")
     };
 
     Prop palm_right = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/palm-head-right.png")
+        .sprite = create_sprite(game.renderer, "assets/sprites/scenario/palm-head-right.png")
     };
 
     Prop lake = {
-        .texture = lake_animation.frames[0],
+        .sprite = lake_animation.frames[0],
     };
 
     Prop ocean = {
-        .texture = ocean_animation.frames[0],
+        .sprite = ocean_animation.frames[0],
     };
     
     Prop sky = {
-        .texture = sky_animation.frames[0],
+        .sprite = sky_animation.frames[0],
     };
 
     Prop mountains = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/mountains.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/scenario/mountains.png"),
         .collision = {0, 0, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2}
     };
 
     Prop sun = {
-        .texture = sun_animation.frames[0]
+        .sprite = sun_animation.frames[0]
     };
 
     Prop clouds = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/clouds.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/scenario/clouds.png"),
         .collision = {0, 0, SCREEN_WIDTH * 2, 155}
     };
-    SDL_SetTextureAlphaMod(clouds.texture, 200);
+    sprite_set_alpha(clouds.sprite, 200);
     SDL_Rect clouds_clone = {clouds.collision.x - clouds.collision.w, 0, SCREEN_WIDTH * 2, 155};
 
     Prop mountains_back = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/mountains-back.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/scenario/mountains-back.png"),
         .collision = {0, 0, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2}
     };
 
     Prop bubble_speech = {
-        .texture = create_texture(game.renderer, "assets/sprites/battle/text-bubble.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/battle/text-bubble.png"),
     };
 
-    SDL_Texture* fight_b_textures[] = {create_texture(game.renderer, "assets/sprites/hud/button-fight.png"), create_texture(game.renderer, "assets/sprites/hud/button-fight-select.png")};
+    Sprite* fight_b_sprites[] = {create_sprite(game.renderer, "assets/sprites/hud/button-fight.png"), create_sprite(game.renderer, "assets/sprites/hud/button-fight-select.png")};
     Prop button_fight = {
-        .texture = fight_b_textures[1],
+        .sprite = fight_b_sprites[1],
         .collision = {26, SCREEN_HEIGHT - 68, 128, 48}
     };
 
-    SDL_Texture* act_b_textures[] = {create_texture(game.renderer, "assets/sprites/hud/button-act.png"), create_texture(game.renderer, "assets/sprites/hud/button-act-select.png")};
+    Sprite* act_b_sprites[] = {create_sprite(game.renderer, "assets/sprites/hud/button-act.png"), create_sprite(game.renderer, "assets/sprites/hud/button-act-select.png")};
     Prop button_act = {
-        .texture = act_b_textures[0],
+        .sprite = act_b_sprites[0],
         .collision = {button_fight.collision.x + button_fight.collision.w + 26, SCREEN_HEIGHT - 68, 128, 48}
     };
 
-    SDL_Texture* item_b_textures[] = {create_texture(game.renderer, "assets/sprites/hud/button-item.png"), create_texture(game.renderer, "assets/sprites/hud/button-item-select.png")};
+    Sprite* item_b_sprites[] = {create_sprite(game.renderer, "assets/sprites/hud/button-item.png"), create_sprite(game.renderer, "assets/sprites/hud/button-item-select.png")};
     Prop button_item = {
-        .texture = item_b_textures[0],
+        .sprite = item_b_sprites[0],
         .collision = {button_act.collision.x + button_act.collision.w + 25, SCREEN_HEIGHT - 68, 128, 48}
     };
 
-    SDL_Texture* leave_b_textures[] = {create_texture(game.renderer, "assets/sprites/hud/button-leave.png"), create_texture(game.renderer, "assets/sprites/hud/button-leave-select.png")};
+    Sprite* leave_b_sprites[] = {create_sprite(game.renderer, "assets/sprites/hud/button-leave.png"), create_sprite(game.renderer, "assets/sprites/hud/button-leave-select.png")};
     Prop button_leave = {
-        .texture = leave_b_textures[0],
+        .sprite = leave_b_sprites[0],
         .collision = {button_item.collision.x + button_item.collision.w + 25, SCREEN_HEIGHT - 68, 128, 48}
     };
 
     // PROPS DA BATALHA:
-    int battle_text_width, battle_text_height;
     Prop battle_name = {
-        .texture = create_text(game.renderer, "MENEGHETTI", battle_text_font, white),
+        .sprite = sprite_from_texture(create_text(game.renderer, "MENEGHETTI", battle_text_font, white)),
     };
-    SDL_QueryTexture(battle_name.texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    battle_name.collision = (SDL_Rect){button_fight.collision.x + 6, button_fight.collision.y - battle_text_height - 8, battle_text_width,battle_text_height};
+    battle_name.collision = (SDL_Rect){button_fight.collision.x + 6, button_fight.collision.y - battle_name.sprite->h - 8, battle_name.sprite->w,battle_name.sprite->h};
 
     Prop battle_hp = {
-        .texture = create_text(game.renderer, "HP", battle_text_font, white),
+        .sprite = sprite_from_texture(create_text(game.renderer, "HP", battle_text_font, white)),
     };
-    SDL_QueryTexture(battle_hp.texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    battle_hp.collision = (SDL_Rect){button_act.collision.x + 35, button_fight.collision.y - battle_text_height - 8, battle_text_width, battle_text_height};
+    battle_hp.collision = (SDL_Rect){button_act.collision.x + 35, button_fight.collision.y - battle_hp.sprite->h - 8, battle_hp.sprite->w, battle_hp.sprite->h};
 
-    Prop battle_hp_amount = {
-        .texture = create_text(game.renderer, "20/20", battle_text_font, white),
-    };
-    SDL_QueryTexture(battle_hp_amount.texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    battle_hp_amount.collision = (SDL_Rect){button_act.collision.x + 140, button_fight.collision.y - battle_text_height - 8, battle_text_width, battle_text_height};
+    GlyphAtlas *hud_atlas = glyph_atlas_get(game.renderer, battle_text_font, white);
 
-    Prop food_amount_text = {
-        .texture = create_text(game.renderer, "4x", battle_text_font, white),
-    };
-    SDL_QueryTexture(food_amount_text.texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    food_amount_text.collision = (SDL_Rect){0, 0, battle_text_width, battle_text_height};
+    HudText battle_hp_amount = hud_text_create(hud_atlas, "%02d/20", 20);
+    battle_hp_amount.collision.x = button_act.collision.x + 140;
+    battle_hp_amount.collision.y = button_fight.collision.y - battle_hp_amount.collision.h - 8;
+
+    HudText food_amount_text = hud_text_create(hud_atlas, "%dx", 4);
 
     Prop text_attack_act = {
-        .texture = create_text(game.renderer, "* Mr. Python", dialogue_text_font, white),
+        .sprite = sprite_from_texture(create_text(game.renderer, "* Mr. Python", dialogue_text_font, white)),
     };
-    SDL_QueryTexture(text_attack_act.texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    text_attack_act.collision = (SDL_Rect){69, (SCREEN_HEIGHT / 2) + 25, battle_text_width, battle_text_height};
+    text_attack_act.collision = (SDL_Rect){69, (SCREEN_HEIGHT / 2) + 25, text_attack_act.sprite->w, text_attack_act.sprite->h};
 
-    Prop text_item = {
-        .texture = create_text(game.renderer, "* Picanha", dialogue_text_font, white)
-    };
-    SDL_QueryTexture(text_item.texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    text_item.collision = (SDL_Rect){69, (SCREEN_HEIGHT / 2) + 25, battle_text_width, battle_text_height};
-
-    Prop text_act[3];
-    text_act[0].texture = create_text(game.renderer, "* Examinar", dialogue_text_font, white);
-    SDL_QueryTexture(text_act[0].texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    text_act[0].collision = (SDL_Rect){69, (SCREEN_HEIGHT / 2) + 25, battle_text_width, battle_text_height};
-    text_act[1].texture = create_text(game.renderer, "* Insultar", dialogue_text_font, white);
-    SDL_QueryTexture(text_act[1].texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    text_act[1].collision = (SDL_Rect){69, text_act[0].collision.y + text_act[0].collision.h + 10, battle_text_width, battle_text_height};
-    text_act[2].texture = create_text(game.renderer, "* Explicar", dialogue_text_font, white);
-    SDL_QueryTexture(text_act[2].texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    text_act[2].collision = (SDL_Rect){text_act[0].collision.x + text_act[0].collision.w + 100, text_act[0].collision.y, battle_text_width, battle_text_height};
-
-    Prop text_leave[2];
-    text_leave[0].texture = create_text(game.renderer, "* Poupar", dialogue_text_font, white);
-    SDL_QueryTexture(text_leave[0].texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    text_leave[0].collision = (SDL_Rect){69, (SCREEN_HEIGHT / 2) + 25, battle_text_width, battle_text_height};
-    text_leave[1].texture = create_text(game.renderer, "* Fugir", dialogue_text_font, white);
-    SDL_QueryTexture(text_leave[1].texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    text_leave[1].collision = (SDL_Rect){69, text_leave[0].collision.y + text_leave[0].collision.h + 10, battle_text_width, battle_text_height};
+    // MENUS DE BATALHA (DESENHADOS EM LOTE A PARTIR DO ATLAS DE GLIFOS):
+    GlyphAtlas *menu_atlas = glyph_atlas_get(game.renderer, dialogue_text_font, white);
+    const char *item_label = "* Picanha";
+    const char *act_labels[] = {"* Examinar", "* Insultar", "* Explicar"};
+    const char *leave_labels[] = {"* Poupar", "* Fugir"};
+
+    Prop text_item = {0};
+    glyph_atlas_measure(menu_atlas, item_label, &text_item.collision.w, &text_item.collision.h);
+    text_item.collision.x = 69;
+    text_item.collision.y = (SCREEN_HEIGHT / 2) + 25;
+
+    Prop text_act[3] = {0};
+    for (int i = 0; i < 3; i++) {
+        glyph_atlas_measure(menu_atlas, act_labels[i], &text_act[i].collision.w, &text_act[i].collision.h);
+    }
+    text_act[0].collision.x = 69;
+    text_act[0].collision.y = (SCREEN_HEIGHT / 2) + 25;
+    text_act[1].collision.x = 69;
+    text_act[1].collision.y = text_act[0].collision.y + text_act[0].collision.h + 10;
+    text_act[2].collision.x = text_act[0].collision.x + text_act[0].collision.w + 100;
+    text_act[2].collision.y = text_act[0].collision.y;
+
+    Prop text_leave[2] = {0};
+    for (int i = 0; i < 2; i++) {
+        glyph_atlas_measure(menu_atlas, leave_labels[i], &text_leave[i].collision.w, &text_leave[i].collision.h);
+    }
+    text_leave[0].collision.x = 69;
+    text_leave[0].collision.y = (SCREEN_HEIGHT / 2) + 25;
+    text_leave[1].collision.x = 69;
+    text_leave[1].collision.y = text_leave[0].collision.y + text_leave[0].collision.h + 10;
 
     Prop bar_target = {
-        .texture = create_texture(game.renderer, "assets/sprites/battle/bar-target.png"),
+        .sprite = create_sprite(game.renderer, "assets/sprites/battle/bar-target.png"),
         .collision = {25, (SCREEN_HEIGHT / 2) + 5, SCREEN_WIDTH - 50, 122}
     };
     Prop bar_attack = {
-        .texture = bar_attack_animation.frames[0],
+        .sprite = bar_attack_animation.frames[0],
         .collision = {bar_target.collision.x + 20, bar_target.collision.y + 2, 14, bar_target.collision.h - 4}
     };
 
-    int attack_widths, attack_heights;
     Projectile command_rain[6];
-    command_rain[0].texture = create_texture(game.renderer, "assets/sprites/battle/if.png");
-    SDL_QueryTexture(command_rain[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[1].texture = create_texture(game.renderer, "assets/sprites/battle/else.png");
-    SDL_QueryTexture(command_rain[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[2].texture = create_texture(game.renderer, "assets/sprites/battle/elif.png");
-    SDL_QueryTexture(command_rain[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[3].texture = create_texture(game.renderer, "assets/sprites/battle/input.png");
-    SDL_QueryTexture(command_rain[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[4].texture = create_texture(game.renderer, "assets/sprites/battle/print.png");
-    SDL_QueryTexture(command_rain[4].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[4].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[5].texture = create_texture(game.renderer, "assets/sprites/battle/in.png");
-    SDL_QueryTexture(command_rain[5].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[5].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
+    command_rain[0].sprite = create_sprite(game.renderer, "assets/sprites/battle/if.png");
+    command_rain[0].collision = (SDL_FRect){0, 0, command_rain[0].sprite->w, command_rain[0].sprite->h};
+    command_rain[1].sprite = create_sprite(game.renderer, "assets/sprites/battle/else.png");
+    command_rain[1].collision = (SDL_FRect){0, 0, command_rain[1].sprite->w, command_rain[1].sprite->h};
+    command_rain[2].sprite = create_sprite(game.renderer, "assets/sprites/battle/elif.png");
+    command_rain[2].collision = (SDL_FRect){0, 0, command_rain[2].sprite->w, command_rain[2].sprite->h};
+    command_rain[3].sprite = create_sprite(game.renderer, "assets/sprites/battle/input.png");
+    command_rain[3].collision = (SDL_FRect){0, 0, command_rain[3].sprite->w, command_rain[3].sprite->h};
+    command_rain[4].sprite = create_sprite(game.renderer, "assets/sprites/battle/print.png");
+    command_rain[4].collision = (SDL_FRect){0, 0, command_rain[4].sprite->w, command_rain[4].sprite->h};
+    command_rain[5].sprite = create_sprite(game.renderer, "assets/sprites/battle/in.png");
+    command_rain[5].collision = (SDL_FRect){0, 0, command_rain[5].sprite->w, command_rain[5].sprite->h};
 
     Projectile parenthesis_enclosure[6];
-    parenthesis_enclosure[0].texture = create_texture(game.renderer, "assets/sprites/battle/brackets-1.png");
-    SDL_QueryTexture(parenthesis_enclosure[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[1].texture = create_texture(game.renderer, "assets/sprites/battle/brackets-2.png");
-    SDL_QueryTexture(parenthesis_enclosure[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[2].texture = create_texture(game.renderer, "assets/sprites/battle/key-1.png");
-    SDL_QueryTexture(parenthesis_enclosure[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[3].texture = create_texture(game.renderer, "assets/sprites/battle/key-2.png");
-    SDL_QueryTexture(parenthesis_enclosure[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[4].texture = create_texture(game.renderer, "assets/sprites/battle/parenthesis-1.png");
-    SDL_QueryTexture(parenthesis_enclosure[4].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[4].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[5].texture = create_texture(game.renderer, "assets/sprites/battle/parenthesis-2.png");
-    SDL_QueryTexture(parenthesis_enclosure[5].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[5].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
+    parenthesis_enclosure[0].sprite = create_sprite(game.renderer, "assets/sprites/battle/brackets-1.png");
+    parenthesis_enclosure[0].collision = (SDL_FRect){0, 0, parenthesis_enclosure[0].sprite->w, parenthesis_enclosure[0].sprite->h * 2};
+    parenthesis_enclosure[1].sprite = create_sprite(game.renderer, "assets/sprites/battle/brackets-2.png");
+    parenthesis_enclosure[1].collision = (SDL_FRect){0, 0, parenthesis_enclosure[1].sprite->w, parenthesis_enclosure[1].sprite->h * 2};
+    parenthesis_enclosure[2].sprite = create_sprite(game.renderer, "assets/sprites/battle/key-1.png");
+    parenthesis_enclosure[2].collision = (SDL_FRect){0, 0, parenthesis_enclosure[2].sprite->w, parenthesis_enclosure[2].sprite->h * 2};
+    parenthesis_enclosure[3].sprite = create_sprite(game.renderer, "assets/sprites/battle/key-2.png");
+    parenthesis_enclosure[3].collision = (SDL_FRect){0, 0, parenthesis_enclosure[3].sprite->w, parenthesis_enclosure[3].sprite->h * 2};
+    parenthesis_enclosure[4].sprite = create_sprite(game.renderer, "assets/sprites/battle/parenthesis-1.png");
+    parenthesis_enclosure[4].collision = (SDL_FRect){0, 0, parenthesis_enclosure[4].sprite->w, parenthesis_enclosure[4].sprite->h * 2};
+    parenthesis_enclosure[5].sprite = create_sprite(game.renderer, "assets/sprites/battle/parenthesis-2.png");
+    parenthesis_enclosure[5].collision = (SDL_FRect){0, 0, parenthesis_enclosure[5].sprite->w, parenthesis_enclosure[5].sprite->h * 2};
 
     Projectile python_mother[3];
-    python_mother[0].texture = python_mother_animation.frames[0];
-    SDL_QueryTexture(python_mother[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_mother[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    python_mother[1].texture = python_mother_animation.frames[1];
-    SDL_QueryTexture(python_mother[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_mother[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    python_mother[2].texture = python_baby_animation.frames[0];
-    SDL_QueryTexture(python_mother[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_mother[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
+    python_mother[0].sprite = python_mother_animation.frames[0];
+    python_mother[0].collision = (SDL_FRect){0, 0, python_mother[0].sprite->w, python_mother[0].sprite->h};
+    python_mother[1].sprite = python_mother_animation.frames[1];
+    python_mother[1].collision = (SDL_FRect){0, 0, python_mother[1].sprite->w, python_mother[1].sprite->h};
+    python_mother[2].sprite = python_baby_animation.frames[0];
+    python_mother[2].collision = (SDL_FRect){0, 0, python_mother[2].sprite->w, python_mother[2].sprite->h};
     python_mother[2].animation = python_baby_animation;
 
     Projectile python_barrier[2];
-    python_barrier[0].texture = python_barrier_left_animation.frames[0];
-    SDL_QueryTexture(python_barrier[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_barrier[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
+    python_barrier[0].sprite = python_barrier_left_animation.frames[0];
+    python_barrier[0].collision = (SDL_FRect){0, 0, python_barrier[0].sprite->w, python_barrier[0].sprite->h};
     python_barrier[0].animation = python_barrier_left_animation;
-    python_barrier[1].texture = python_barrier_right_animation.frames[1];
-    SDL_QueryTexture(python_barrier[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_barrier[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
+    python_barrier[1].sprite = python_barrier_right_animation.frames[1];
+    python_barrier[1].collision = (SDL_FRect){0, 0, python_barrier[1].sprite->w, python_barrier[1].sprite->h};
     python_barrier[1].animation = python_barrier_right_animation;
 
     Projectile *python_props[] = {command_rain, parenthesis_enclosure, python_mother, python_barrier};
 
-    SDL_Texture* damage_numbers[] = {create_texture(game.renderer, "assets/sprites/battle/number-10.png"), create_texture(game.renderer, "assets/sprites/battle/number-20.png"), create_texture(game.renderer, "assets/sprites/battle/number-30.png"), create_texture(game.renderer, "assets/sprites/battle/number-40.png")};
+    Sprite* damage_numbers[] = {create_sprite(game.renderer, "assets/sprites/battle/number-10.png"), create_sprite(game.renderer, "assets/sprites/battle/number-20.png"), create_sprite(game.renderer, "assets/sprites/battle/number-30.png"), create_sprite(game.renderer, "assets/sprites/battle/number-40.png")};
     Prop damage;
 
     // SONS:
-    Sound cutscene_music = {
-        .sound = create_chunk("assets/sounds/soundtracks/the_story_of_a_hero.wav", MUSIC_VOLUME),
+    Music cutscene_music = {
+        .music = create_music(CUTSCENE_MUSIC_PATH),
         .has_played = false
     };
 
-    Sound battle_music = {
-        .sound = create_chunk("assets/sounds/soundtracks/battle_against_abstraction.wav", MUSIC_VOLUME),
+    Music battle_music = {
+        .music = create_music(BATTLE_MUSIC_PATH),
         .has_played = false
     };
 
-    Sound ambience = {
-        .sound = create_chunk("assets/sounds/sound_effects/in-game/ambient_sound.wav", MUSIC_VOLUME),
+    Music ambience = {
+        .music = create_music(AMBIENCE_MUSIC_PATH),
         .has_played = false
     };
 
@@ -1249,22 +2409,22 @@ int main(int argc, char* argv[]) {
     // FRAMES DA CUTSCENE:
     CutsceneFrame frame_1 = {
         .text = &cutscene_1,
-        .image = create_texture(game.renderer, "assets/sprites/misc/story-frame-1.png"),
+        .image = create_sprite(game.renderer, "assets/sprites/misc/story-frame-1.png"),
         .duration = 10.0
     };
     CutsceneFrame frame_2 = {
         .text = &cutscene_2,
-        .image = create_texture(game.renderer, "assets/sprites/misc/story-frame-2.png"),
+        .image = create_sprite(game.renderer, "assets/sprites/misc/story-frame-2.png"),
         .duration = 10.0
     };
     CutsceneFrame frame_3 = {
         .text = &cutscene_3,
-        .image = create_texture(game.renderer, "assets/sprites/misc/story-frame-1.2.png"),
+        .image = create_sprite(game.renderer, "assets/sprites/misc/story-frame-1.2.png"),
         .duration = 12.0
     };
     CutsceneFrame frame_4 = {
         .text = &cutscene_4,
-        .image = create_texture(game.renderer, "assets/sprites/misc/story-frame-4.png"),
+        .image = create_sprite(game.renderer, "assets/sprites/misc/story-frame-4.png"),
         .duration = 13.5
     };
 
@@ -1272,23 +2432,23 @@ int main(int argc, char* argv[]) {
     int cutscene_amount = sizeof(cutscene) / sizeof(cutscene[0]);
 
     // OBJETOS DE DEBUG:
+    GlyphAtlas *debug_atlas = glyph_atlas_get(game.renderer, bubble_text_font, white);
     Prop debug_buttons[6];
-    debug_buttons[0].texture = create_texture(game.renderer, "assets/sprites/misc/button-1.png");
+    debug_buttons[0].sprite = create_sprite(game.renderer, "assets/sprites/misc/button-1.png");
     debug_buttons[0].collision = (SDL_Rect){25, 25, 25, 25};
-    debug_buttons[1].texture = create_texture(game.renderer, "assets/sprites/misc/button-2.png");
+    debug_buttons[1].sprite = create_sprite(game.renderer, "assets/sprites/misc/button-2.png");
     debug_buttons[1].collision = (SDL_Rect){75, 25, 25, 25};
-    debug_buttons[2].texture = create_texture(game.renderer, "assets/sprites/misc/button-3.png");
+    debug_buttons[2].sprite = create_sprite(game.renderer, "assets/sprites/misc/button-3.png");
     debug_buttons[2].collision = (SDL_Rect){125, 25, 25, 25};
-    debug_buttons[3].texture = create_texture(game.renderer, "assets/sprites/misc/button-4.png");
+    debug_buttons[3].sprite = create_sprite(game.renderer, "assets/sprites/misc/button-4.png");
     debug_buttons[3].collision = (SDL_Rect){175, 25, 25, 25};
-    debug_buttons[4].texture = create_texture(game.renderer, "assets/sprites/misc/button-5.png");
+    debug_buttons[4].sprite = create_sprite(game.renderer, "assets/sprites/misc/button-5.png");
     debug_buttons[4].collision = (SDL_Rect){225, 25, 25, 25};
-    debug_buttons[5].texture = create_texture(game.renderer, "assets/sprites/misc/button-6.png");
+    debug_buttons[5].sprite = create_sprite(game.renderer, "assets/sprites/misc/button-6.png");
     debug_buttons[5].collision = (SDL_Rect){275, 25, 25, 25};
     
     SDL_Rect animated_box;
 
-    Uint32 last_ticks = SDL_GetTicks();
     double anim_timer = 0.0;
     const double anim_interval = 0.12;
 
@@ -1337,12 +2497,41 @@ int main(int argc, char* argv[]) {
     
     const float parallax_factor = 0.5f;
 
+    loader_finish();
+    profile_finish();
+    if (sprite_failures > 0) {
+        fprintf(stderr, "Error loading assets: %d sprites missing\n", sprite_failures);
+        game_cleanup(&game, EXIT_FAILURE);
+    }
+    if (startup_benchmark)
+        game_cleanup(&game, EXIT_SUCCESS);
+
+    // RESIDÊNCIA DOS SONS:
+    Sound *single_sounds[] = {&civic_engine, &civic_brake, &civic_door, &title_sound,
+                              &battle_appears, &move_button, &click_button, &slash_sound, &enemy_hit_sound, &eat_sound, &soul_break_sound};
+    for (size_t i = 0; i < sizeof(single_sounds) / sizeof(single_sounds[0]); i++) {
+        residency_track_sounds(single_sounds[i], 1);
+    }
+    residency_track_sounds(walking_sounds, 6);
+    residency_track_sounds(battle_sounds, 5);
+    residency_track_sounds(dialogue_voices, 4);
+    residency_update(game.renderer, game_flags.game_state);
+    sampler_init(&sampler, &game_flags);
+
     while (running) {
+        // a drenagem do amostrador é custo do próprio perfilador e fica fora das fases:
+        sampler_drain(&sampler);
+        perf_mark(&perf_hud);
         while (SDL_PollEvent(&event)) {
             switch (event.type) {
             case SDL_QUIT:
                 running = SDL_FALSE;
                 break;
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                layer_cache_invalidate(&parallax_cache);
+                dirty_invalidate(&dirty_renderer);
+                break;
 
             case SDL_KEYDOWN:
                 switch (event.key.keysym.scancode)
@@ -1351,6 +2540,9 @@ int main(int argc, char* argv[]) {
                     if (game_flags.player_state == MOVABLE)
                         game_flags.interaction_request = true;
                     break;
+                case SDL_SCANCODE_F8:
+                    trace_dump_next();
+                    break;
                 case SDL_SCANCODE_F7:
                     if (game_flags.debug_mode) {
                         game_flags.debug_mode = false;
@@ -1476,9 +2668,9 @@ int main(int argc, char* argv[]) {
                                     bar_attack.collision.x = bar_target.collision.x + 20;
 
                                     mr_python_head.health = 200;
-                                    mr_python_head.texture = python_head_animation.frames[0];
-                                    mr_python_arms.texture = python_arms_animation.frames[0];
-                                    mr_python_legs.texture = python_legs_animation.frames[0];
+                                    mr_python_head.sprite = python_head_animation.frames[0];
+                                    mr_python_arms.sprite = python_arms_animation.frames[0];
+                                    mr_python_legs.sprite = python_legs_animation.frames[0];
 
                                     soul_animation.counter = 0;
                                     slash_animation.counter = 0;
@@ -1549,10 +2741,10 @@ int main(int argc, char* argv[]) {
                                 reset_dialogue(&end_dialogue);
 
                                 soul.collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) - 10, 20, 20};
-                                soul.texture = soul_animation.frames[0];
+                                soul.sprite = soul_animation.frames[0];
                             
                                 game_flags.interaction_request = false;
-                                Mix_HaltChannel(MUSIC_CHANNEL);
+                                Mix_HaltMusic();
                                 Mix_HaltChannel(SFX_CHANNEL);
                             }
                         }
@@ -1563,20 +2755,56 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        Uint32 now = SDL_GetTicks();
-        double dt = (now - last_ticks) / 1000.0;
-        if (dt > 0.25) dt = 0.25;
-        last_ticks = now;
+        // CADA VOLTA DO LAÇO É UM TICK FIXO; SÓ O ÚLTIMO TICK DE UM QUADRO É APRESENTADO:
+        perf_phase(&perf_hud, PERF_INPUT);
+
+        if (sim_clock.pending == 0) {
+            // sem tela o tempo é virtual: cada quadro avança exatamente um tick, então nada é reenviado.
+            double frame_time = frame_pacer_frame(&frame_pacer);
+            if (headless.enabled) frame_time = SIM_DT;
+
+            if (sim_clock_advance(&sim_clock, frame_time) == 0) {
+                // nenhum tick venceu ainda: o último quadro é reenviado com a interpolação atualizada.
+                if (render_queue_replay(game.renderer)) {
+                    sim_clock.replays++;
+                    perf_phase(&perf_hud, PERF_SUBMIT);
+                    SDL_RenderPresent(game.renderer);
+                    perf_phase(&perf_hud, PERF_PRESENT);
+                    flight_record(&flight_recorder, &game_flags);
+                    perf_frame_end(&perf_hud, game_flags.game_state, true);
+                    frame_pacer_wait(&frame_pacer);
+                }
+                // sem nada apresentado nem o vsync segura o laço: dorme até o próximo tick vencer.
+                else frame_pacer_idle(&frame_pacer, (1.0 - sim_clock.alpha) * SIM_DT);
+                continue;
+            }
+        }
+        sim_clock.pending--;
+        sim_clock.ticks++;
+        bool render_tick = sim_clock.pending == 0;
+        const double dt = SIM_DT;
+        int tick_state = game_flags.game_state;
+
+        residency_update(game.renderer, game_flags.game_state);
+        resource_set_state(game_flags.game_state);
+        render_queue_set_state(game_flags.game_state);
+        // fora das telas estáticas o backbuffer envelhece: voltar para a mesma tela precisa redesenhar tudo.
+        if (tick_state != TITLE_SCREEN && tick_state != DEATH_SCREEN) dirty_renderer.screen = -1;
+        if (render_tick) cull_stats_frame();
+        render_queue_begin(!render_tick);
+        const char *state_zone_name = game_flags.game_state >= 0 && game_flags.game_state < GAME_STATE_COUNT ? game_state_names[game_flags.game_state] : "unknown";
+        hardware_counters.state = game_flags.game_state;
+        Uint64 state_zone = trace_begin();
 
         if (game_flags.game_state == CUTSCENE) {
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 0);
+            render_set_color(game.renderer, 0, 0, 0, 0);
 
             if (game_flags.pre_title) {
                 game_flags.pre_title_timer += dt;
                 
-                SDL_RenderClear(game.renderer);
-                SDL_RenderCopy(game.renderer, title.texture, NULL, &title.collision);
+                render_clear(game.renderer);
+                render_sprite(game.renderer, title.sprite, &title.collision);
 
                 if (game_flags.pre_title_timer >= 5.0) {
                     game_flags.pre_title = false;
@@ -1584,7 +2812,7 @@ int main(int argc, char* argv[]) {
             }
             else {
                 if (!cutscene_music.has_played) {
-                    Mix_PlayChannel(MUSIC_CHANNEL, cutscene_music.sound, 0);
+                    play_music(&cutscene_music, 0);
                     cutscene_music.has_played = true;
                 }
                 CutsceneFrame *current_frame = &cutscene[game_flags.cutscene_index];
@@ -1620,9 +2848,9 @@ int main(int argc, char* argv[]) {
                     }
                 }
 
-                SDL_SetTextureAlphaMod(current_frame->image, cutscene_fade.alpha);
-                SDL_RenderClear(game.renderer);
-                SDL_RenderCopy(game.renderer, current_frame->image, NULL, NULL);
+                sprite_set_alpha(current_frame->image, cutscene_fade.alpha);
+                render_clear(game.renderer);
+                render_sprite(game.renderer, current_frame->image, NULL);
 
                 if (current_frame->text) {
                     create_dialogue(&meneghetti, game.renderer, current_frame->text, &game_flags.player_state, &game_flags.game_state, dt, NULL, NULL, dialogue_voices, false);
@@ -1644,32 +2872,42 @@ int main(int argc, char* argv[]) {
 
                 if (interaction_request) {
                     game_state = TITLE_SCREEN;
-                    Mix_HaltChannel(MUSIC_CHANNEL);
-                    SDL_SetTextureAlphaMod(current_frame->image, 255);
+                    Mix_HaltMusic();
+                    sprite_set_alpha(current_frame->image, 255);
                 }
                 if (last_frame_extend && cutscene_fade.timer >= 3.0) {
                     game_state = TITLE_SCREEN;
-                    SDL_SetTextureAlphaMod(current_frame->image, 255);
+                    sprite_set_alpha(current_frame->image, 255);
                 }
             }
             interaction_request = false;
         }
 
         if (game_state == TITLE_SCREEN) {
-            const Uint8 *keys = meneghetti.keystate ? meneghetti.keystate : SDL_GetKeyboardState(NULL);
+            residency_prefetch(OPEN_WORLD);
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer);
-            SDL_RenderCopy(game.renderer, title.texture, NULL, &title.collision);
+            const Uint8 *keys = meneghetti.keystate ? meneghetti.keystate : SDL_GetKeyboardState(NULL);
 
             if (!title_sound.has_played) {
                 Mix_PlayChannel(SFX_CHANNEL, title_sound.sound, 0);
                 title_sound.has_played = true;
             }
-            if (!Mix_Playing(SFX_CHANNEL)) {
-                title_text.texture = animate_sprite(&title_text_anim, dt, 0.7, false);
-                SDL_RenderCopy(game.renderer, title_text.texture, NULL, &title_text.collision);
+            bool show_title_text = !Mix_Playing(SFX_CHANNEL);
+            if (show_title_text) {
+                title_text.sprite = animate_sprite(&title_text_anim, dt, 0.7, false);
+            }
 
+            dirty_track(&dirty_renderer, 0, title.sprite, &title.collision);
+            dirty_track(&dirty_renderer, 1, show_title_text ? title_text.sprite : NULL, &title_text.collision);
+            if (dirty_begin(game.renderer, &dirty_renderer, TITLE_SCREEN)) {
+                render_set_color(game.renderer, 0, 0, 0, 255);
+                dirty_clear(game.renderer, &dirty_renderer);
+                render_sprite(game.renderer, title.sprite, &title.collision);
+                if (show_title_text) render_sprite(game.renderer, title_text.sprite, &title_text.collision);
+            }
+            dirty_end(game.renderer, &dirty_renderer);
+
+            if (show_title_text) {
                 if (keys[SDL_SCANCODE_RETURN]) {
                     title_sound.has_played = false;
                     player_state = IDLE;
@@ -1689,7 +2927,7 @@ int main(int argc, char* argv[]) {
                 }
             }
             if (!ambience.has_played) {
-                Mix_PlayChannel(MUSIC_CHANNEL, ambience.sound, -1);
+                play_music(&ambience, -1);
                 ambience.has_played = true;
             }
 
@@ -1756,6 +2994,12 @@ int main(int argc, char* argv[]) {
             if (player_state == MOVABLE) {
                 sprite_update(&scenario, &meneghetti, anim_pack, dt, boxes, surfaces, &anim_timer, anim_interval, walking_sounds);
             }
+
+            // A batalha só começa pelo Mr. Python: perto dele, o grupo da batalha já é decodificado em segundo plano.
+            SDL_Rect python_area = {boxes[8].x - PREFETCH_MARGIN, boxes[8].y - PREFETCH_MARGIN, boxes[8].w + PREFETCH_MARGIN * 2, boxes[8].h + PREFETCH_MARGIN * 2};
+            if (rects_intersect(&meneghetti.interact_collision, &python_area, NULL)) {
+                residency_prefetch(BATTLE_SCREEN);
+            }
             if (interaction_request) {
                 if (rects_intersect(&meneghetti.interact_collision, &boxes[8], NULL))
                     player_state = DIALOGUE;
@@ -1771,54 +3015,44 @@ int main(int argc, char* argv[]) {
 
             update_reflection(&meneghetti, &meneghetti_reflection, anim_pack_reflex);
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer); 
-
-            SDL_RenderCopy(game.renderer, sky.texture, NULL, &sky.collision);
-            SDL_RenderCopy(game.renderer, sun.texture, NULL, &sun.collision);
-            SDL_RenderCopy(game.renderer, clouds.texture, NULL, &clouds.collision);
-            SDL_RenderCopy(game.renderer, clouds.texture, NULL, &clouds_clone);
-            SDL_RenderCopy(game.renderer, mountains_back.texture, NULL, &mountains_back.collision);
-            SDL_RenderCopy(game.renderer, mountains.texture, NULL, &mountains.collision);
-            SDL_RenderCopy(game.renderer, ocean.texture, NULL, &ocean.collision);
-            SDL_RenderCopy(game.renderer, lake.texture, NULL, &lake.collision);
-            SDL_RenderCopyEx(game.renderer, meneghetti_reflection.texture, NULL, &meneghetti_reflection.collision, 0, NULL, SDL_FLIP_VERTICAL);
-            SDL_RenderCopy(game.renderer, scenario.texture, NULL, &scenario.collision);
-
-            mr_python.texture = animate_sprite(&mr_python_animation[mr_python.facing], dt, 3.0, true);
-            lake.texture = animate_sprite(&lake_animation, dt, 0.5, false);
-            ocean.texture = animate_sprite(&ocean_animation, dt, 0.7, false);
-            sky.texture = animate_sprite(&sky_animation, dt, 0.8, false);
-            sun.texture = animate_sprite(&sun_animation, dt, 0.5, false);
-
-            RenderItem items[2];
-            int item_count = 0;
-
-            items[item_count].texture = mr_python.texture;
-            items[item_count].collisions = &mr_python.collision;
-            item_count ++;
-
-            items[item_count].texture = python_van.texture;
-            items[item_count].collisions = &python_van.collision;
-            item_count ++;
-            
-            if (meneghetti_arrived) {
-                items[item_count].texture = civic.texture;
-                items[item_count].collisions = &civic.collision;
-                item_count ++;
-
-                items[item_count].texture = meneghetti.texture;
-                items[item_count].collisions = &meneghetti.collision;
-                item_count++;
-            }
+            render_set_color(game.renderer, 0, 0, 0, 255);
+            render_clear(game.renderer); 
+
+            // SÓ CÉU E SOL (1/8 DO DESLOCAMENTO, ANIMAÇÃO LENTA) FICAM EM CACHE; NUVENS E MONTANHAS MUDAM QUASE TODO FRAME:
+            layer_cache_begin(&parallax_cache);
+            layer_cache_add(&parallax_cache, sky.sprite, &sky.collision);
+            layer_cache_add(&parallax_cache, sun.sprite, &sun.collision);
+            layer_cache_draw(game.renderer, &parallax_cache);
+            render_sprite(game.renderer, clouds.sprite, &clouds.collision);
+            render_sprite(game.renderer, clouds.sprite, &clouds_clone);
+            render_sprite(game.renderer, mountains_back.sprite, &mountains_back.collision);
+            render_sprite(game.renderer, mountains.sprite, &mountains.collision);
+            render_sprite(game.renderer, ocean.sprite, &ocean.collision);
+            render_sprite(game.renderer, lake.sprite, &lake.collision);
+            render_sprite_ex(game.renderer, meneghetti_reflection.sprite, &meneghetti_reflection.collision, 0, SDL_FLIP_VERTICAL);
+            render_sprite(game.renderer, scenario.sprite, &scenario.collision);
+
+            mr_python.sprite = animate_sprite(&mr_python_animation[mr_python.facing], dt, 3.0, true);
+            lake.sprite = animate_sprite(&lake_animation, dt, 0.5, false);
+            ocean.sprite = animate_sprite(&ocean_animation, dt, 0.7, false);
+            sky.sprite = animate_sprite(&sky_animation, dt, 0.8, false);
+            sun.sprite = animate_sprite(&sun_animation, dt, 0.5, false);
+
+            // PERSONAGENS SÃO ORDENADOS PELA BASE (y + h) NA PRÓPRIA FILA DE DESENHO:
+            render_queue_layer(RENDER_LAYER_ACTORS);
+            render_queue_depth(mr_python.collision.y + mr_python.collision.h);
+            render_sprite(game.renderer, mr_python.sprite, &mr_python.collision);
+            render_queue_depth(python_van.collision.y + python_van.collision.h);
+            render_sprite(game.renderer, python_van.sprite, &python_van.collision);
 
-            qsort(items, item_count, sizeof(RenderItem), renderitem_cmp);
-
-            for (int i = 0; i < item_count; i++) {
-                if (items[i].texture && items[i].collisions) {
-                    SDL_RenderCopy(game.renderer, items[i].texture, NULL, items[i].collisions);
-                }
+            if (meneghetti_arrived) {
+                render_queue_depth(civic.collision.y + civic.collision.h);
+                render_sprite(game.renderer, civic.sprite, &civic.collision);
+                render_queue_depth(meneghetti.collision.y + meneghetti.collision.h);
+                render_sprite(game.renderer, meneghetti.sprite, &meneghetti.collision);
             }
+            render_queue_depth(RENDER_DEPTH_ORDERED);
+            render_queue_layer(RENDER_LAYER_FOREGROUND);
 
             if (first_dialogue && player_state == DIALOGUE) {
                 arrival_timer += dt;
@@ -1890,19 +3124,19 @@ int main(int argc, char* argv[]) {
                     if (!Mix_Playing(SFX_CHANNEL))
                         Mix_PlayChannel(SFX_CHANNEL, civic_engine.sound, 0);
                     
-                    SDL_RenderCopy(game.renderer, meneghetti_civic.texture, NULL, &meneghetti_civic.collision);
+                    render_sprite(game.renderer, meneghetti_civic.sprite, &meneghetti_civic.collision);
                     meneghetti_civic.collision.x -= 5;
                     meneghetti_civic.collision.y = (int)((scenario.collision.y + 731) + 2 * sin(car_animation_timer * 30.0)); 
                 }
                 else if (!delay_started) {
                     Mix_PlayChannel(SFX_CHANNEL, civic_brake.sound, 0);
                     
-                    SDL_RenderCopy(game.renderer, meneghetti_civic.texture, NULL, &meneghetti_civic.collision);
+                    render_sprite(game.renderer, meneghetti_civic.sprite, &meneghetti_civic.collision);
                     delay_started = true;
                     arrival_timer = 0.0;
                 }
                 else {
-                    SDL_RenderCopy(game.renderer, meneghetti_civic.texture, NULL, &meneghetti_civic.collision);
+                    render_sprite(game.renderer, meneghetti_civic.sprite, &meneghetti_civic.collision);
                     if (delay_started && !Mix_Playing(SFX_CHANNEL)) {
                         arrival_timer += dt;
                         if (arrival_timer >= 2.0) {
@@ -1916,15 +3150,15 @@ int main(int argc, char* argv[]) {
                         }
                     }
                 }
-                SDL_RenderCopy(game.renderer, palm_left.texture, NULL, &palm_left.collision);
-                SDL_RenderCopy(game.renderer, palm_right.texture, NULL, &palm_right.collision);
+                render_sprite(game.renderer, palm_left.sprite, &palm_left.collision);
+                render_sprite(game.renderer, palm_right.sprite, &palm_right.collision);
             }
             if (open_world_fade.alpha > 0) {
-                SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, open_world_fade.alpha);
-                SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
+                render_set_color(game.renderer, 0, 0, 0, open_world_fade.alpha);
+                render_set_blend(game.renderer, SDL_BLENDMODE_BLEND);
 
                 SDL_Rect screen_fade = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-                SDL_RenderFillRect(game.renderer, &screen_fade);
+                render_fill_rect(game.renderer, &screen_fade);
             }
         }
 
@@ -1942,9 +3176,7 @@ int main(int argc, char* argv[]) {
             
             SDL_Rect base_box = {20, SCREEN_HEIGHT / 2, SCREEN_WIDTH - 40, 132};
 
-            char x_number[3];
-            snprintf(x_number, sizeof(x_number), "%dx", food_amount);
-            food_amount_text.texture = create_text(game.renderer, x_number, battle_text_font, white);
+            hud_text_set(&food_amount_text, food_amount);
 
             if (!animated_box_inited) {
                 animated_box = base_box;
@@ -1963,22 +3195,22 @@ int main(int argc, char* argv[]) {
             SDL_Rect py_life_background = {(SCREEN_WIDTH / 2) - 100, 200, 200, 10};
             SDL_Rect py_life = {(SCREEN_WIDTH / 2) - 100, 200, 200, 10};
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer);
+            render_set_color(game.renderer, 0, 0, 0, 255);
+            render_clear(game.renderer);
 
             if (!battle_ready) {
                 counter += dt;
 
-                SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
+                render_sprite(game.renderer, soul.sprite, &soul.collision);
                 if (counter <= 0.5) {
                     if (!battle_appears.has_played) {
                         Mix_PlayChannel(SFX_CHANNEL, battle_appears.sound, 0);
                         battle_appears.has_played = true;
                     }
-                    soul.texture = animate_sprite(&soul_animation, dt, 0.1, false);
+                    soul.sprite = animate_sprite(&soul_animation, dt, 0.1, false);
                 }
                 else {
-                    soul.texture = soul_animation.frames[0];
+                    soul.sprite = soul_animation.frames[0];
                     if (soul.collision.x != button_fight.collision.x + 30 || soul.collision.y != button_fight.collision.y + 30) {
                         if (abs(soul.collision.x - (button_fight.collision.x + 30)) <= 5)
                             soul.collision.x = button_fight.collision.x + 30;
@@ -1995,7 +3227,7 @@ int main(int argc, char* argv[]) {
                             soul.collision.y += 5;
                     }
                     else {
-                        soul.texture = soul_animation.frames[0];
+                        soul.sprite = soul_animation.frames[0];
                         battle_appears.has_played = false;
                         battle_ready = true;
                         counter = 0.0;
@@ -2004,7 +3236,7 @@ int main(int argc, char* argv[]) {
             }
             else {
                 if (!battle_music.has_played) {
-                    Mix_PlayChannel(MUSIC_CHANNEL, battle_music.sound, 0);
+                    play_music(&battle_music, 0);
                     battle_music.has_played = true;
                 }
                 counter += dt;
@@ -2012,40 +3244,39 @@ int main(int argc, char* argv[]) {
                 if (counter >= 0.4) counter = 0.2;
 
                 if (meneghetti.health != last_health) {
-                    char hp_string[6];
-                    snprintf(hp_string, sizeof(hp_string), "%02d/20", meneghetti.health);
-
-                    battle_hp_amount.texture = create_text(game.renderer, hp_string, battle_text_font, white);
-
+                    hud_text_set(&battle_hp_amount, meneghetti.health);
                     last_health = meneghetti.health;
                 }
 
-                SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-                SDL_RenderFillRect(game.renderer, &base_box);
-                SDL_SetRenderDrawColor(game.renderer, 255, 255, 255, 255);
-                SDL_RenderFillRects(game.renderer, box_borders, 4);
-                SDL_SetRenderDrawColor(game.renderer, 168, 24, 13, 255);
-                SDL_RenderFillRect(game.renderer, &life_bar_background);
-                SDL_SetRenderDrawColor(game.renderer, 204, 195, 18, 255);
-                SDL_RenderFillRect(game.renderer, &life_bar);
-
-                SDL_RenderCopy(game.renderer, button_fight.texture, NULL, &button_fight.collision);
-                SDL_RenderCopy(game.renderer, button_act.texture, NULL, &button_act.collision);
-                SDL_RenderCopy(game.renderer, button_item.texture, NULL, &button_item.collision);
-                SDL_RenderCopy(game.renderer, button_leave.texture, NULL, &button_leave.collision);
-                SDL_RenderCopy(game.renderer, battle_name.texture, NULL, &battle_name.collision);
-                SDL_RenderCopy(game.renderer, battle_hp.texture, NULL, &battle_hp.collision);
-                SDL_RenderCopy(game.renderer, battle_hp_amount.texture, NULL, &battle_hp_amount.collision);
+                render_set_color(game.renderer, 0, 0, 0, 255);
+                render_fill_rect(game.renderer, &base_box);
+                render_set_color(game.renderer, 255, 255, 255, 255);
+                render_fill_rects(game.renderer, box_borders, 4);
+                render_set_color(game.renderer, 168, 24, 13, 255);
+                render_fill_rect(game.renderer, &life_bar_background);
+                render_set_color(game.renderer, 204, 195, 18, 255);
+                render_fill_rect(game.renderer, &life_bar);
+
+                // o HUD não se sobrepõe, então a fila pode agrupá-lo por textura:
+                render_queue_group_begin();
+                render_sprite(game.renderer, button_fight.sprite, &button_fight.collision);
+                render_sprite(game.renderer, button_act.sprite, &button_act.collision);
+                render_sprite(game.renderer, button_item.sprite, &button_item.collision);
+                render_sprite(game.renderer, button_leave.sprite, &button_leave.collision);
+                render_sprite(game.renderer, battle_name.sprite, &battle_name.collision);
+                render_sprite(game.renderer, battle_hp.sprite, &battle_hp.collision);
+                hud_text_render(game.renderer, &battle_hp_amount);
+                render_queue_group_end();
 
                 // MR. PYTHON
                 mr_python_head.collision.y = (int)(25 + 2 * sin(senoidal_timer * 1.5));
                 mr_python_torso.collision.y = (int)(25 + 3 * sin(senoidal_timer * 1.5));
                 mr_python_arms.collision.y = (int)(25 + 4 * sin(senoidal_timer * 1.5));
 
-                SDL_RenderCopy(game.renderer, mr_python_arms.texture, NULL, &mr_python_arms.collision);
-                SDL_RenderCopy(game.renderer, mr_python_legs.texture, NULL, &mr_python_legs.collision);
-                SDL_RenderCopy(game.renderer, mr_python_torso.texture, NULL, &mr_python_torso.collision);
-                SDL_RenderCopy(game.renderer, mr_python_head.texture, NULL, &mr_python_head.collision);
+                render_sprite(game.renderer, mr_python_arms.sprite, &mr_python_arms.collision);
+                render_sprite(game.renderer, mr_python_legs.sprite, &mr_python_legs.collision);
+                render_sprite(game.renderer, mr_python_torso.sprite, &mr_python_torso.collision);
+                render_sprite(game.renderer, mr_python_head.sprite, &mr_python_head.collision);
 
                 if (battle_state == ON_MENU) {
                     if (!first_dialogue) {
@@ -2072,28 +3303,28 @@ int main(int argc, char* argv[]) {
 
                     switch(selected_button) {
                         case FIGHT:
-                            button_fight.texture = fight_b_textures[1];
-                            button_act.texture = act_b_textures[0];
-                            button_item.texture = item_b_textures[0];
-                            button_leave.texture = leave_b_textures[0];
+                            button_fight.sprite = fight_b_sprites[1];
+                            button_act.sprite = act_b_sprites[0];
+                            button_item.sprite = item_b_sprites[0];
+                            button_leave.sprite = leave_b_sprites[0];
                             break;
                         case ACT:
-                            button_fight.texture = fight_b_textures[0];
-                            button_act.texture = act_b_textures[1];
-                            button_item.texture = item_b_textures[0];
-                            button_leave.texture = leave_b_textures[0];
+                            button_fight.sprite = fight_b_sprites[0];
+                            button_act.sprite = act_b_sprites[1];
+                            button_item.sprite = item_b_sprites[0];
+                            button_leave.sprite = leave_b_sprites[0];
                             break;
                         case ITEM:
-                            button_fight.texture = fight_b_textures[0];
-                            button_act.texture = act_b_textures[0];
-                            button_item.texture = item_b_textures[1];
-                            button_leave.texture = leave_b_textures[0];
+                            button_fight.sprite = fight_b_sprites[0];
+                            button_act.sprite = act_b_sprites[0];
+                            button_item.sprite = item_b_sprites[1];
+                            button_leave.sprite = leave_b_sprites[0];
                             break;
                         case LEAVE:
-                            button_fight.texture = fight_b_textures[0];
-                            button_act.texture = act_b_textures[0];
-                            button_item.texture = item_b_textures[0];
-                            button_leave.texture = leave_b_textures[1];
+                            button_fight.sprite = fight_b_sprites[0];
+                            button_act.sprite = act_b_sprites[0];
+                            button_item.sprite = item_b_sprites[0];
+                            button_leave.sprite = leave_b_sprites[1];
                             break;
                         default:
                             break;
@@ -2138,8 +3369,8 @@ int main(int argc, char* argv[]) {
                         soul.collision.x = text_attack_act.collision.x - soul.collision.w - 11;
                         soul.collision.y = text_attack_act.collision.y + 2;
 
-                        SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                        SDL_RenderCopy(game.renderer, text_attack_act.texture, NULL, &text_attack_act.collision);
+                        render_sprite(game.renderer, soul.sprite, &soul.collision);
+                        render_sprite(game.renderer, text_attack_act.sprite, &text_attack_act.collision);
 
                         if (keys[SDL_SCANCODE_TAB] && counter >= 0.2) {
                             Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
@@ -2157,8 +3388,8 @@ int main(int argc, char* argv[]) {
                         int attack_damage;
 
                         static int bar_speed = 14;
-                        SDL_RenderCopy(game.renderer, bar_target.texture, NULL, &bar_target.collision);
-                        SDL_RenderCopy(game.renderer, bar_attack.texture, NULL, &bar_attack.collision);
+                        render_sprite(game.renderer, bar_target.sprite, &bar_target.collision);
+                        render_sprite(game.renderer, bar_attack.sprite, &bar_attack.collision);
                         if (bar_attack.collision.x + bar_attack.collision.w > bar_target.collision.x + bar_target.collision.w - bar_speed) {
                             bar_speed = -bar_speed;
                         }
@@ -2168,7 +3399,6 @@ int main(int argc, char* argv[]) {
 
                         if (!tried_to_attack) {
                             if (e_just_pressed && counter >= 0.2) {
-                                int w, h;
                                 tried_to_attack = true;
 
                                 damage.collision.x = py_life.x + py_life.w;
@@ -2176,31 +3406,27 @@ int main(int argc, char* argv[]) {
                                 
                                 if (rects_intersect(&bar_attack.collision, &perfect_hit_rect, NULL)) {
                                     attack_damage = meneghetti.strength * 3;
-                                    damage.texture = damage_numbers[3];
-                                    SDL_QueryTexture(damage.texture, NULL, NULL, &w, &h);
-                                    damage.collision.w = w;
-                                    damage.collision.h = h;
+                                    damage.sprite = damage_numbers[3];
+                                    damage.collision.w = damage.sprite->w;
+                                    damage.collision.h = damage.sprite->h;
                                 }
                                 else if (rects_intersect(&bar_attack.collision, &good_hit_rect, NULL)) {
                                     attack_damage = meneghetti.strength * 1.5;
-                                    damage.texture = damage_numbers[2];
-                                    SDL_QueryTexture(damage.texture, NULL, NULL, &w, &h);
-                                    damage.collision.w = w;
-                                    damage.collision.h = h;
+                                    damage.sprite = damage_numbers[2];
+                                    damage.collision.w = damage.sprite->w;
+                                    damage.collision.h = damage.sprite->h;
                                 }
                                 else if (rects_intersect(&bar_attack.collision, &normal_hit_rect, NULL)) {
                                     attack_damage = meneghetti.strength;
-                                    damage.texture = damage_numbers[1];
-                                    SDL_QueryTexture(damage.texture, NULL, NULL, &w, &h);
-                                    damage.collision.w = w;
-                                    damage.collision.h = h;
+                                    damage.sprite = damage_numbers[1];
+                                    damage.collision.w = damage.sprite->w;
+                                    damage.collision.h = damage.sprite->h;
                                 }
                                 else if (rects_intersect(&bar_attack.collision, &bad_hit_rect, NULL)) {
                                     attack_damage = meneghetti.strength * 0.5;
-                                    damage.texture = damage_numbers[0];
-                                    SDL_QueryTexture(damage.texture, NULL, NULL, &w, &h);
-                                    damage.collision.w = w;
-                                    damage.collision.h = h;
+                                    damage.sprite = damage_numbers[0];
+                                    damage.collision.w = damage.sprite->w;
+                                    damage.collision.h = damage.sprite->h;
                                 }
                             }
 
@@ -2211,27 +3437,27 @@ int main(int argc, char* argv[]) {
 
 
                             if (blink_timer <= 3.0) {
-                                bar_attack.texture = animate_sprite(&bar_attack_animation, dt, 0.1, false);
+                                bar_attack.sprite = animate_sprite(&bar_attack_animation, dt, 0.1, false);
 
                                 if (!slash_sound.has_played) {
                                     Mix_PlayChannel(SFX_CHANNEL, slash_sound.sound, 0);
                                     slash_sound.has_played = true;
                                 }
-                                SDL_RenderCopy(game.renderer, slash.texture, NULL, &slash.collision);
+                                render_sprite(game.renderer, slash.sprite, &slash.collision);
                                 if (slash_animation.counter < 5) {
-                                    slash.texture = animate_sprite(&slash_animation, dt, 0.2, false);
+                                    slash.sprite = animate_sprite(&slash_animation, dt, 0.2, false);
                                     if (slash_animation.counter > 3) {
                                         if (!enemy_hit_sound.has_played) {
                                             Mix_PlayChannel(SFX_CHANNEL, enemy_hit_sound.sound, 0);
                                             enemy_hit_sound.has_played = true;
                                             mr_python_head.health -= attack_damage;
                                         }
-                                        SDL_RenderCopy(game.renderer, damage.texture, NULL, &damage.collision);
+                                        render_sprite(game.renderer, damage.sprite, &damage.collision);
                                         damage.collision.y--;
 
-                                        mr_python_head.texture = python_head_animation.frames[1];
-                                        mr_python_arms.texture = python_arms_animation.frames[1];
-                                        mr_python_legs.texture = python_legs_animation.frames[1];
+                                        mr_python_head.sprite = python_head_animation.frames[1];
+                                        mr_python_arms.sprite = python_arms_animation.frames[1];
+                                        mr_python_legs.sprite = python_legs_animation.frames[1];
                                         
                                         mr_python_head.collision.x = ((SCREEN_WIDTH / 2) - 102) + 4 * sin(senoidal_timer * 40.0);
                                         mr_python_torso.collision.x = ((SCREEN_WIDTH / 2) - 102) + 4 * sin(senoidal_timer * 40.0);
@@ -2240,10 +3466,10 @@ int main(int argc, char* argv[]) {
                                     }
                                 }
                                 else {
-                                    slash.texture = NULL;
+                                    slash.sprite = NULL;
                                 }
-                                SDL_SetRenderDrawColor(game.renderer, 168, 24, 13, 255);
-                                SDL_RenderFillRect(game.renderer, &py_life_background);
+                                render_set_color(game.renderer, 168, 24, 13, 255);
+                                render_fill_rect(game.renderer, &py_life_background);
                                 
                                 static double py_display_width = 200.0;
                                 double target_width = (double)mr_python_head.health;
@@ -2260,17 +3486,17 @@ int main(int argc, char* argv[]) {
 
                                 py_life.w = (int)(py_display_width + 0.5);
 
-                                SDL_SetRenderDrawColor(game.renderer, 8, 207, 21, 255);
-                                SDL_RenderFillRect(game.renderer, &py_life);
+                                render_set_color(game.renderer, 8, 207, 21, 255);
+                                render_fill_rect(game.renderer, &py_life);
 
                                 if (slash_animation.counter > 3) {
-                                    SDL_RenderCopy(game.renderer, damage.texture, NULL, &damage.collision);
+                                    render_sprite(game.renderer, damage.sprite, &damage.collision);
                                 }
                             }   
                             else {
-                                mr_python_head.texture = python_head_animation.frames[0];
-                                mr_python_arms.texture = python_arms_animation.frames[0];
-                                mr_python_legs.texture = python_legs_animation.frames[0];
+                                mr_python_head.sprite = python_head_animation.frames[0];
+                                mr_python_arms.sprite = python_arms_animation.frames[0];
+                                mr_python_legs.sprite = python_legs_animation.frames[0];
 
                                 slash_sound.has_played = false;
                                 enemy_hit_sound.has_played = false;
@@ -2298,9 +3524,9 @@ int main(int argc, char* argv[]) {
                         if (soul_ivulnerable) {
                             ivulnerability_counter += dt;
 
-                            soul.texture = animate_sprite(&soul_animation, dt, 0.1, false);
+                            soul.sprite = animate_sprite(&soul_animation, dt, 0.1, false);
                             if (ivulnerability_counter >= 1.0) {
-                                soul.texture = soul_animation.frames[0];
+                                soul.sprite = soul_animation.frames[0];
                                 soul_ivulnerable = false;
                                 ivulnerability_counter = 0.0;
                             }
@@ -2327,7 +3553,7 @@ int main(int argc, char* argv[]) {
                         }
                         else if (!should_expand_back) {
                             turn_timer += dt;
-                            SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
+                            render_sprite(game.renderer, soul.sprite, &soul.collision);
 
                             if (turn_timer <= 10.0) {
                                 if (keys[SDL_SCANCODE_W]) {
@@ -2382,7 +3608,7 @@ int main(int argc, char* argv[]) {
                                 reset_dialogue(&bubble_speech_3);
 
                                 python_attacks(game.renderer, &soul, animated_box, &meneghetti.health, current_py_damage, enemy_attack, &soul_ivulnerable, python_props, dt, turn_timer, battle_sounds, true);
-                                python_props[2][0].texture = python_mother_animation.frames[0];
+                                python_props[2][0].sprite = python_mother_animation.frames[0];
                                 should_expand_back = true;
                                 animated_shrink_timer = 0.0;
                                 turn_timer = 0.0;
@@ -2435,8 +3661,8 @@ int main(int argc, char* argv[]) {
                             soul.collision.x = text_attack_act.collision.x - soul.collision.w - 11;
                             soul.collision.y = text_attack_act.collision.y + 2;
 
-                            SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                            SDL_RenderCopy(game.renderer, text_attack_act.texture, NULL, &text_attack_act.collision);
+                            render_sprite(game.renderer, soul.sprite, &soul.collision);
+                            render_sprite(game.renderer, text_attack_act.sprite, &text_attack_act.collision);
 
                             if (keys[SDL_SCANCODE_TAB] && counter >= 0.2) {
                                 Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
@@ -2472,10 +3698,12 @@ int main(int argc, char* argv[]) {
                                     break;
                                 }
 
-                                SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                                SDL_RenderCopy(game.renderer, text_act[0].texture, NULL, &text_act[0].collision);
-                                SDL_RenderCopy(game.renderer, text_act[1].texture, NULL, &text_act[1].collision);
-                                SDL_RenderCopy(game.renderer, text_act[2].texture, NULL, &text_act[2].collision);
+                                render_sprite(game.renderer, soul.sprite, &soul.collision);
+                                text_batch_begin(&text_batch, menu_atlas);
+                                for (int i = 0; i < 3; i++) {
+                                    text_batch_string(&text_batch, act_labels[i], text_act[i].collision.x, text_act[i].collision.y);
+                                }
+                                text_batch_flush(game.renderer, &text_batch);
 
                                 if (keys[SDL_SCANCODE_TAB] && counter >= 0.2) {
                                     Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
@@ -2607,9 +3835,11 @@ int main(int argc, char* argv[]) {
                             food_amount_text.collision.x = text_item.collision.x + text_item.collision.w + 5;
                             food_amount_text.collision.y = text_item.collision.y;
 
-                            SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                            SDL_RenderCopy(game.renderer, text_item.texture, NULL, &text_item.collision);
-                            SDL_RenderCopy(game.renderer, food_amount_text.texture, NULL, &food_amount_text.collision);
+                            render_sprite(game.renderer, soul.sprite, &soul.collision);
+                            text_batch_begin(&text_batch, menu_atlas);
+                            text_batch_string(&text_batch, item_label, text_item.collision.x, text_item.collision.y);
+                            text_batch_flush(game.renderer, &text_batch);
+                            hud_text_render(game.renderer, &food_amount_text);
 
                             if (keys[SDL_SCANCODE_TAB] && counter >= 0.2) {
                                 Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
@@ -2664,9 +3894,12 @@ int main(int argc, char* argv[]) {
                                     break;
                             }
 
-                            SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                            SDL_RenderCopy(game.renderer, text_leave[0].texture, NULL, &text_leave[0].collision);
-                            SDL_RenderCopy(game.renderer, text_leave[1].texture, NULL, &text_leave[1].collision);
+                            render_sprite(game.renderer, soul.sprite, &soul.collision);
+                            text_batch_begin(&text_batch, menu_atlas);
+                            for (int i = 0; i < 2; i++) {
+                                text_batch_string(&text_batch, leave_labels[i], text_leave[i].collision.x, text_leave[i].collision.y);
+                            }
+                            text_batch_flush(game.renderer, &text_batch);
 
                             if (keys[SDL_SCANCODE_TAB] && counter >= 0.2) {
                                 Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
@@ -2708,9 +3941,9 @@ int main(int argc, char* argv[]) {
                     battle_state = ON_MENU;
                     turn = CHOICE_TURN;
 
-                    mr_python_head.texture = python_head_animation.frames[1];
-                    mr_python_arms.texture = python_arms_animation.frames[1];
-                    mr_python_legs.texture = python_legs_animation.frames[1];
+                    mr_python_head.sprite = python_head_animation.frames[1];
+                    mr_python_arms.sprite = python_arms_animation.frames[1];
+                    mr_python_legs.sprite = python_legs_animation.frames[1];
                     
                     mr_python_head.collision.x = ((SCREEN_WIDTH / 2) - 102) + 4 * sin(senoidal_timer * 40.0);
                     mr_python_torso.collision.x = ((SCREEN_WIDTH / 2) - 102) + 4 * sin(senoidal_timer * 40.0);
@@ -2732,22 +3965,22 @@ int main(int argc, char* argv[]) {
                     }
 
                     if (end_scene_fade.alpha < 255) {
-                        SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, end_scene_fade.alpha);
-                        SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
+                        render_set_color(game.renderer, 0, 0, 0, end_scene_fade.alpha);
+                        render_set_blend(game.renderer, SDL_BLENDMODE_BLEND);
 
                         SDL_Rect screen_fade = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-                        SDL_RenderFillRect(game.renderer, &screen_fade);
+                        render_fill_rect(game.renderer, &screen_fade);
                     }
                 }
             }
             if (player_state == DEAD || python_dead) {
-                Mix_HaltChannel(MUSIC_CHANNEL);
+                Mix_HaltMusic();
 
-                mr_python_head.texture = python_head_animation.frames[0];
-                mr_python_arms.texture = python_arms_animation.frames[0];
-                mr_python_legs.texture = python_legs_animation.frames[0];
+                mr_python_head.sprite = python_head_animation.frames[0];
+                mr_python_arms.sprite = python_arms_animation.frames[0];
+                mr_python_legs.sprite = python_legs_animation.frames[0];
 
-                python_props[2][0].texture = python_mother_animation.frames[0];
+                python_props[2][0].sprite = python_mother_animation.frames[0];
                 senoidal_timer = 0.0;
                 counter = 0.0;
                 battle_ready = false;
@@ -2776,45 +4009,28 @@ int main(int argc, char* argv[]) {
 
                 python_attacks(game.renderer, &soul, animated_box, &meneghetti.health, current_py_damage, 0, &soul_ivulnerable, python_props, dt, turn_timer, battle_sounds, true);
 
-                int attack_widths, attack_heights;
-                SDL_QueryTexture(command_rain[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[4].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[4].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[5].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[5].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-
-                SDL_QueryTexture(parenthesis_enclosure[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[4].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[4].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[5].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[5].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-
-                python_mother[0].texture = python_mother_animation.frames[0];
-                SDL_QueryTexture(python_mother[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-                python_mother[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                python_mother[1].texture = python_mother_animation.frames[1];
-                SDL_QueryTexture(python_mother[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-                python_mother[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                python_mother[2].texture = python_baby_animation.frames[0];
-                SDL_QueryTexture(python_mother[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-                python_mother[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                python_mother[3].texture = python_baby_animation.frames[1];
-                SDL_QueryTexture(python_mother[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-                python_mother[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
+                command_rain[0].collision = (SDL_FRect){0, 0, command_rain[0].sprite->w, command_rain[0].sprite->h};
+                command_rain[1].collision = (SDL_FRect){0, 0, command_rain[1].sprite->w, command_rain[1].sprite->h};
+                command_rain[2].collision = (SDL_FRect){0, 0, command_rain[2].sprite->w, command_rain[2].sprite->h};
+                command_rain[3].collision = (SDL_FRect){0, 0, command_rain[3].sprite->w, command_rain[3].sprite->h};
+                command_rain[4].collision = (SDL_FRect){0, 0, command_rain[4].sprite->w, command_rain[4].sprite->h};
+                command_rain[5].collision = (SDL_FRect){0, 0, command_rain[5].sprite->w, command_rain[5].sprite->h};
+
+                parenthesis_enclosure[0].collision = (SDL_FRect){0, 0, parenthesis_enclosure[0].sprite->w, parenthesis_enclosure[0].sprite->h};
+                parenthesis_enclosure[1].collision = (SDL_FRect){0, 0, parenthesis_enclosure[1].sprite->w, parenthesis_enclosure[1].sprite->h};
+                parenthesis_enclosure[2].collision = (SDL_FRect){0, 0, parenthesis_enclosure[2].sprite->w, parenthesis_enclosure[2].sprite->h};
+                parenthesis_enclosure[3].collision = (SDL_FRect){0, 0, parenthesis_enclosure[3].sprite->w, parenthesis_enclosure[3].sprite->h};
+                parenthesis_enclosure[4].collision = (SDL_FRect){0, 0, parenthesis_enclosure[4].sprite->w, parenthesis_enclosure[4].sprite->h};
+                parenthesis_enclosure[5].collision = (SDL_FRect){0, 0, parenthesis_enclosure[5].sprite->w, parenthesis_enclosure[5].sprite->h};
+
+                python_mother[0].sprite = python_mother_animation.frames[0];
+                python_mother[0].collision = (SDL_FRect){0, 0, python_mother[0].sprite->w, python_mother[0].sprite->h};
+                python_mother[1].sprite = python_mother_animation.frames[1];
+                python_mother[1].collision = (SDL_FRect){0, 0, python_mother[1].sprite->w, python_mother[1].sprite->h};
+                python_mother[2].sprite = python_baby_animation.frames[0];
+                python_mother[2].collision = (SDL_FRect){0, 0, python_mother[2].sprite->w, python_mother[2].sprite->h};
+                python_mother[3].sprite = python_baby_animation.frames[1];
+                python_mother[3].collision = (SDL_FRect){0, 0, python_mother[3].sprite->w, python_mother[3].sprite->h};
 
                 python_props[0] = command_rain;
                 python_props[1] = parenthesis_enclosure;
@@ -2841,17 +4057,24 @@ int main(int argc, char* argv[]) {
         }
 
         if (game_state == DEATH_SCREEN) {
+            residency_prefetch(OPEN_WORLD);
+
             death_counter += dt;
+            bool show_soul = death_counter <= 2.0;
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer);
+            dirty_track(&dirty_renderer, 2, show_soul ? soul_shattered.sprite : NULL, &soul.collision);
+            if (dirty_begin(game.renderer, &dirty_renderer, DEATH_SCREEN)) {
+                render_set_color(game.renderer, 0, 0, 0, 255);
+                dirty_clear(game.renderer, &dirty_renderer);
+                if (show_soul) render_sprite(game.renderer, soul_shattered.sprite, &soul.collision);
+            }
+            dirty_end(game.renderer, &dirty_renderer);
 
-            if (death_counter <= 2.0) {
+            if (show_soul) {
                 if (!soul_break_sound.has_played) {
                     Mix_PlayChannel(SFX_CHANNEL, soul_break_sound.sound, 0);
                     soul_break_sound.has_played = true;
                 }
-                SDL_RenderCopy(game.renderer, soul_shattered.texture, NULL, &soul.collision);
             }
             else {
                 open_world_fade.alpha = (Uint8)255;
@@ -2891,17 +4114,17 @@ int main(int argc, char* argv[]) {
                 }
             }
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer);
+            render_set_color(game.renderer, 0, 0, 0, 255);
+            render_clear(game.renderer);
 
             create_dialogue(&meneghetti, game.renderer, &end_dialogue, &player_state, &game_state, dt, meneghetti_dialogue, &python_dialogue, &anim_timer, dialogue_voices, false);
 
             if (end_scene_fade.alpha > 0) {
-                SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, end_scene_fade.alpha);
-                SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
+                render_set_color(game.renderer, 0, 0, 0, end_scene_fade.alpha);
+                render_set_blend(game.renderer, SDL_BLENDMODE_BLEND);
 
                 SDL_Rect screen_fade = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-                SDL_RenderFillRect(game.renderer, &screen_fade);
+                render_fill_rect(game.renderer, &screen_fade);
             }
             if (player_state == MOVABLE) {
                 open_world_fade.alpha = (Uint8)255;
@@ -2928,19 +4151,39 @@ int main(int argc, char* argv[]) {
                 meneghetti.health = 20;
                 last_health = meneghetti.health;
 
-                SDL_RenderClear(game.renderer);
+                render_clear(game.renderer);
             }
         }
 
         if (debug_mode) {
+            render_queue_layer(RENDER_LAYER_DEBUG);
             for (int i = 0; i < 6; i++) {
-                SDL_RenderCopy(game.renderer, debug_buttons[i].texture, NULL, &debug_buttons[i].collision);
+                render_sprite(game.renderer, debug_buttons[i].sprite, &debug_buttons[i].collision);
             }
+            int overlay_y = resource_overlay(game.renderer, debug_atlas, 25, 65);
+            overlay_y = cull_overlay(game.renderer, debug_atlas, 25, overlay_y);
+            render_queue_overlay(game.renderer, debug_atlas, 25, overlay_y);
+            perf_overlay(game.renderer, debug_atlas, SCREEN_WIDTH - PERF_HISTORY - 25, 65);
         }
 
+        trace_end(state_zone_name, state_zone);
+        perf_phase(&perf_hud, PERF_UPDATE);
+        perf_tick_end(&perf_hud, tick_state);
+        if (!render_tick) continue;
+
+        Uint64 zone = trace_begin();
+        render_queue_flush(game.renderer);
+        trace_end("render_queue_flush", zone);
+        perf_phase(&perf_hud, PERF_SUBMIT);
+        zone = trace_begin();
         SDL_RenderPresent(game.renderer);
+        trace_end("SDL_RenderPresent", zone);
+        perf_phase(&perf_hud, PERF_PRESENT);
+        flight_record(&flight_recorder, &game_flags);
+        perf_frame_end(&perf_hud, game_flags.game_state, false);
+        if (headless_frame(&headless)) running = SDL_FALSE;
 
-        SDL_Delay(1);
+        frame_pacer_wait(&frame_pacer);
     }
 
     for (int i = 0; i < DIR_COUNT; i++) {
@@ -2957,33 +4200,45 @@ int main(int argc, char* argv[]) {
 }
 
 bool sdl_initialize(Game *game) {
+    Uint64 phase = SDL_GetPerformanceCounter();
     if (SDL_Init(SDL_INIT_EVERYTHING)) {
         fprintf(stderr, "Error initializing SDL: %s\n", SDL_GetError());
         return true;
     }
+    profile_record("SDL_Init", "init", phase, 0);
 
+    phase = SDL_GetPerformanceCounter();
     int img_init = IMG_Init(IMAGE_FLAGS);
     if ((img_init & IMAGE_FLAGS) != IMAGE_FLAGS) {
         fprintf(stderr, "Error initializing SDL_image: %s\n", IMG_GetError());
         return true;
     }
+    profile_record("IMG_Init", "init", phase, 0);
 
+    phase = SDL_GetPerformanceCounter();
     int mix_init = Mix_Init(MIXER_FLAGS);
     if ((mix_init & MIXER_FLAGS) != MIXER_FLAGS) {
         fprintf(stderr, "Error initializing SDL_mixer: %s\n", Mix_GetError());
         return true;
     }
+    profile_record("Mix_Init", "init", phase, 0);
 
+    phase = SDL_GetPerformanceCounter();
     if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, 1024)) {
         fprintf(stderr, "Error Opening Audio: %s\n", Mix_GetError());
         return true;
     }
     Mix_AllocateChannels(16);
+    profile_record("Mix_OpenAudio", "init", phase, 0);
 
+    phase = SDL_GetPerformanceCounter();
     if (TTF_Init()) {
         fprintf(stderr, "Error initializing SDL_ttf: %s\n", TTF_GetError());
         return true;
     }
+    profile_record("TTF_Init", "init", phase, 0);
+
+    phase = SDL_GetPerformanceCounter();
 
     game->window = SDL_CreateWindow(GAME_TITLE, SDL_WINDOWPOS_CENTERED,
                                     SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_FLAGS);
@@ -2991,15 +4246,22 @@ bool sdl_initialize(Game *game) {
         fprintf(stderr, "Error creating window: %s\n", SDL_GetError());
         return true;
     }
+    profile_record("SDL_CreateWindow", "init", phase, 0);
+
+    phase = SDL_GetPerformanceCounter();
 
-    game->renderer = SDL_CreateRenderer(game->window, -1, RENDERER_FLAGS);
+    Uint32 renderer_flags = frame_pacer.vsync_requested ? RENDERER_FLAGS : (RENDERER_FLAGS & ~SDL_RENDERER_PRESENTVSYNC);
+    if (headless.enabled) renderer_flags = HEADLESS_RENDERER_FLAGS;
+    game->renderer = SDL_CreateRenderer(game->window, -1, renderer_flags);
     if (!game->renderer) {
         fprintf(stderr, "Error creating renderer: %s\n", SDL_GetError());
         return true;
     }
     SDL_RenderSetLogicalSize(game->renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+    frame_pacer_init(&frame_pacer, game->renderer, game->window);
+    profile_record("SDL_CreateRenderer", "init", phase, 0);
 
-    SDL_Surface* icon = SDL_LoadBMP("assets/sprites/hud/icon.bmp");
+    SDL_Surface* icon = SDL_LoadBMP_RW(asset_open_rw("assets/sprites/hud/icon.bmp"), 1);
     if(!icon) {
         fprintf(stderr, "Error loading icon: %s\n", SDL_GetError());
         return true;
@@ -3015,26 +4277,65 @@ void game_reset(GameState *game) {
 }
 
 SDL_Texture* create_texture(SDL_Renderer *render, const char *dir) {
-    SDL_Surface* surface = IMG_Load(dir);
+    // Texturas são compartilhadas: alpha e tinta ficam no Sprite e são aplicados ao desenhar.
+    // O chamador só empresta a textura; a referência é da entrada do cache e volta quando a residência a despeja.
+    SDL_Texture *texture = cache_find(&texture_cache, dir);
+    if (texture) return texture;
+
+    // Superfícies decodificadas pelo carregador pertencem a ele; só o envio é feito aqui.
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 content_hash = 0;
+    SDL_Surface* decoded = loader_surface(dir, &content_hash);
+    if (decoded) profile_record(dir, "wait", start, 0);
+
+    SDL_Surface* surface = decoded ? decoded : IMG_Load_RW(asset_open_rw(dir), 1);
     if (!surface) {
         fprintf(stderr, "Error loading image '%s': %s\n", dir, IMG_GetError());
         return NULL;
     }
+    if (!decoded) profile_record(dir, "decode", start, (size_t)surface->pitch * surface->h);
+
+    // Arquivos diferentes com os mesmos pixels também reaproveitam a textura; o hash vem pronto das threads do carregador.
+    if (!content_hash) content_hash = hash_surface(surface);
+    texture = cache_find_content(&texture_cache, content_hash, surface);
+    if (texture) {
+        // A nova entrada do cache divide a textura com a outra e segura a própria referência.
+        resource_retain(texture);
+    }
+    else {
+        start = SDL_GetPerformanceCounter();
+        texture = SDL_CreateTextureFromSurface(render, surface);
+        if (texture) {
+            resource_register(texture, RESOURCE_TEXTURE);
+            resource_name(texture, dir);
+        }
+        profile_record(dir, "upload", start, (size_t)surface->w * surface->h * 4);
+    }
 
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(render, surface);
+    if (!decoded) SDL_FreeSurface(surface);
     if (!texture) {
         fprintf(stderr, "Error creating texture: %s", SDL_GetError());
-        SDL_FreeSurface(surface);
         return NULL;
     }
 
-    SDL_FreeSurface(surface);
-    track_texture(texture);
+    cache_insert(&texture_cache, dir, content_hash, texture);
     return texture;
 }
 
 Mix_Chunk* create_chunk(const char *dir, int volume) {
-    Mix_Chunk* chunk = Mix_LoadWAV(dir);
+    // Sons de outros grupos não são decodificados agora: carregam na entrada do estado ou no prefetch.
+    Uint32 states = residency_states(dir);
+    if (states != ALL_STATES && residency_deferred(states)) return residency_defer_chunk(dir, volume, states);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    Mix_Chunk* chunk = loader_chunk(dir);
+    if (chunk) {
+        profile_record(dir, "wait", start, 0);
+    }
+    else {
+        chunk = Mix_LoadWAV_RW(asset_open_rw(dir), 1);
+        if (chunk) profile_record(dir, "decode", start, chunk->alen);
+    }
 
     if (!chunk) {
         fprintf(stderr, "Error loading chunk %s: %s", dir, Mix_GetError());
@@ -3042,22 +4343,88 @@ Mix_Chunk* create_chunk(const char *dir, int volume) {
     }
 
     Mix_VolumeChunk(chunk, volume);
-    track_chunk(chunk);
+    resource_register(chunk, RESOURCE_CHUNK);
+    resource_name(chunk, dir);
+    residency_track_chunk(chunk, dir, volume);
     return chunk;
 }
 
 TTF_Font* create_font(const char *dir, int size) {
-    TTF_Font* font = TTF_OpenFont(dir, size);
+    char key[PATH_LENGTH + 16];
+    snprintf(key, sizeof(key), "%s@%d", dir, size);
+
+    TTF_Font* font = cache_find(&font_cache, key);
+    if (font) return font;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_RWops *rw = asset_open_rw(dir);
+    Sint64 font_bytes = rw ? SDL_RWsize(rw) : 0;
+    font = TTF_OpenFontRW(rw, 1, size);
 
     if (!font) {
         fprintf(stderr, "Error loading font %s: %s", dir, TTF_GetError());
         return NULL;
     }
+    profile_record(key, "load", start, 0);
 
-    track_font(font);
+    resource_register(font, RESOURCE_FONT);
+    resource_name(font, key);
+    if (font_bytes > 0) resource_account(font, (size_t)font_bytes);
+    cache_insert(&font_cache, key, 0, font);
     return font;
 }
 
+Mix_Music* create_music(const char *dir) {
+    // Uma versão .ogg ao lado do .wav tem preferência; os dois tocam em streaming.
+    char compressed[PATH_LENGTH];
+    snprintf(compressed, sizeof(compressed), "%s", dir);
+    char *ext = strrchr(compressed, '.');
+    if (ext) strcpy(ext, ".ogg");
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    Mix_Music* music = NULL;
+    const char *source = dir;
+    Sint64 music_bytes = 0;
+    struct stat info;
+    if (ext && (pack_find(compressed) || stat(compressed, &info) == 0)) {
+        SDL_RWops *rw = asset_open_rw(compressed);
+        music_bytes = rw ? SDL_RWsize(rw) : 0;
+        music = Mix_LoadMUS_RW(rw, 1);
+        if (music) source = compressed;
+    }
+    if (!music) {
+        SDL_RWops *rw = asset_open_rw(dir);
+        music_bytes = rw ? SDL_RWsize(rw) : 0;
+        music = Mix_LoadMUS_RW(rw, 1);
+    }
+
+    if (!music) {
+        fprintf(stderr, "Error loading music %s: %s", dir, Mix_GetError());
+        return NULL;
+    }
+    profile_record(dir, "load", start, 0);
+
+    // como nas fontes, o tamanho contado é o do arquivo de origem, que o stream mantém aberto:
+    resource_register(music, RESOURCE_MUSIC);
+    resource_name(music, source);
+    if (music_bytes > 0) resource_account(music, (size_t)music_bytes);
+    return music;
+}
+
+void play_music(Music *music, int loops) {
+    if (!music->music) return;
+
+    // Mesmo significado de loops de Mix_PlayChannel: 0 toca uma vez, -1 repete para sempre.
+    Mix_VolumeMusic(MUSIC_VOLUME);
+    if (Mix_PlayMusic(music->music, loops < 0 ? -1 : loops + 1)) {
+        fprintf(stderr, "Error playing music: %s\n", Mix_GetError());
+    }
+}
+
+static bool is_streamed_music(const char *path) {
+    return strcmp(path, CUTSCENE_MUSIC_PATH) == 0 || strcmp(path, BATTLE_MUSIC_PATH) == 0 || strcmp(path, AMBIENCE_MUSIC_PATH) == 0;
+}
+
 SDL_Texture* create_text(SDL_Renderer *render, const char *utf8_text, TTF_Font *font, SDL_Color color) {
     if (!utf8_text || !utf8_text[0]) return NULL;
 
@@ -3075,91 +4442,3798 @@ SDL_Texture* create_text(SDL_Renderer *render, const char *utf8_text, TTF_Font *
     }
 
     SDL_FreeSurface(surface);
-    track_texture(texture);
+    resource_register(texture, RESOURCE_TEXTURE);
+    char name[PATH_LENGTH];
+    snprintf(name, sizeof(name), "text '%s'", utf8_text);
+    resource_name(texture, name);
     return texture;
 }
 
-void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *player_state, int *game_state, double dt, Animation *meneghetti_face, Animation *python_face, double *anim_timer, Sound *sound, Prop *bubble_speech) {
-    const Uint8 *keys = player->keystate ? player->keystate : SDL_GetKeyboardState(NULL);
-    
-    bool has_meneghetti = (meneghetti_face != NULL);
-    bool has_python = (python_face != NULL);
-    bool bubble;
-    
-    static double anim_cooldown = 0.2;
+GlyphAtlas *glyph_atlas_get(SDL_Renderer *render, TTF_Font *font, SDL_Color color) {
+    if (!font) return NULL;
 
-    static double e_cooldown = 0.0;
-    static bool prev_e_pressed = false;
-    e_cooldown += dt;
-    bool e_now = keys[SDL_SCANCODE_E];
+    for (int i = 0; i < glyph_atlas_count; i++) {
+        GlyphAtlas *atlas = glyph_atlases[i];
+        if (atlas->font == font && atlas->color.r == color.r && atlas->color.g == color.g && atlas->color.b == color.b && atlas->color.a == color.a) {
+            return atlas;
+        }
+    }
 
-    static int counters[] = {0, 0};
-    
-    bool e_pressed = false;
-    if (e_now && !prev_e_pressed && e_cooldown >= 0.2) {
-        e_pressed = true;
-        e_cooldown = 0.0;
+    if (glyph_atlas_count >= glyph_atlas_capacity) {
+        int capacity = glyph_atlas_capacity ? glyph_atlas_capacity * 2 : 8;
+        GlyphAtlas **atlases = realloc(glyph_atlases, capacity * sizeof(*atlases));
+        if (!atlases) return NULL;
+        glyph_atlases = atlases;
+        glyph_atlas_capacity = capacity;
     }
 
-    prev_e_pressed = e_now;
-    
-    int text_amount = 0;
-    for (int i = 0; i < MAX_DIALOGUE_STR; i++) {
-        if (text->writings[i] == NULL) break;
-        text_amount++;
+    // cada atlas é alocado à parte, então os ponteiros guardados por textos e lotes continuam válidos:
+    GlyphAtlas *atlas = calloc(1, sizeof(*atlas));
+    if (!atlas) return NULL;
+    atlas->font = font;
+    atlas->color = color;
+    atlas->render = render;
+    if (!glyph_atlas_add_page(atlas)) {
+        free(atlas);
+        return NULL;
     }
-    const double timer_delay = 0.04;
-    
-    SDL_Rect dialogue_box = {0, 0, 0, 0};
-    if (bubble_speech) {
-        bubble_speech->collision = dialogue_box;
-        bubble = true;
+
+    glyph_atlases[glyph_atlas_count++] = atlas;
+    return atlas;
+}
+
+static bool glyph_atlas_add_page(GlyphAtlas *atlas) {
+    ResourceHandle *pages = realloc(atlas->pages, (atlas->page_count + 1) * sizeof(*pages));
+    if (!pages) return false;
+    atlas->pages = pages;
+
+    SDL_Texture *texture = SDL_CreateTexture(atlas->render, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE);
+    if (!texture) {
+        fprintf(stderr, "Error creating glyph atlas texture: %s\n", SDL_GetError());
+        return false;
     }
-    else {
-        bubble = false;
+
+    // páginas em streaming começam com conteúdo indefinido:
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, NULL, &pixels, &pitch) == 0) {
+        memset(pixels, 0, (size_t)pitch * GLYPH_ATLAS_SIZE);
+        SDL_UnlockTexture(texture);
     }
-    switch(*game_state) {
-        case CUTSCENE:
-            dialogue_box = (SDL_Rect){20, SCREEN_HEIGHT - 200, SCREEN_WIDTH - 40, 180};
-            break;
-        case OPEN_WORLD:
-            if (player->collision.y + player->collision.h < SCREEN_HEIGHT / 2) {
-                dialogue_box = (SDL_Rect){25, SCREEN_HEIGHT - 175, SCREEN_WIDTH - 50, 150};
-            }
-            else {
-                dialogue_box = (SDL_Rect){25, 25, SCREEN_WIDTH - 50, 150};
-            }
-            break;
-        case BATTLE_SCREEN:
-            if (bubble) {
-                int w, h;
-                SDL_QueryTexture(bubble_speech->texture, NULL, NULL, &w, &h);
-                dialogue_box = (SDL_Rect){380, 40, w * 1.5, h * 1.5};
-            }
-            else {
-                dialogue_box = (SDL_Rect){20, SCREEN_HEIGHT / 2, SCREEN_WIDTH - 40, 132};
-            }
-            break;
-        case FINAL_SCREEN:
-            dialogue_box = (SDL_Rect){25, SCREEN_HEIGHT - 175, SCREEN_WIDTH - 50, 150};
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    if (atlas->page_count > 0) {
+        fprintf(stderr, "Glyph atlas (font size %d) full after %d glyphs, adding page %d\n", TTF_FontHeight(atlas->font), atlas->glyph_count, atlas->page_count + 1);
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "glyph atlas %dpx page %d", TTF_FontHeight(atlas->font), atlas->page_count + 1);
+    atlas->pages[atlas->page_count++] = resource_register(texture, RESOURCE_TEXTURE);
+    resource_name(texture, name);
+    atlas->shelf_x = GLYPH_ATLAS_PADDING;
+    atlas->shelf_y = GLYPH_ATLAS_PADDING;
+    atlas->shelf_h = 0;
+    return true;
+}
+
+static bool glyph_atlas_place(GlyphAtlas *atlas, int w, int h, SDL_Rect *rect) {
+    if (atlas->shelf_x + w + GLYPH_ATLAS_PADDING > GLYPH_ATLAS_SIZE) {
+        atlas->shelf_x = GLYPH_ATLAS_PADDING;
+        atlas->shelf_y += atlas->shelf_h + GLYPH_ATLAS_PADDING;
+        atlas->shelf_h = 0;
+    }
+    if (w + 2 * GLYPH_ATLAS_PADDING > GLYPH_ATLAS_SIZE || atlas->shelf_y + h + GLYPH_ATLAS_PADDING > GLYPH_ATLAS_SIZE) return false;
+
+    *rect = (SDL_Rect){atlas->shelf_x, atlas->shelf_y, w, h};
+    atlas->shelf_x += w + GLYPH_ATLAS_PADDING;
+    if (h > atlas->shelf_h) atlas->shelf_h = h;
+    return true;
+}
+
+int glyph_atlas_glyph(GlyphAtlas *atlas, const char *utf8_char) {
+    if (!atlas || !utf8_char || !utf8_char[0]) return -1;
+
+    Uint32 codepoint = utf8_decode(utf8_char);
+    if (atlas->slot_capacity > 0) {
+        Uint32 mask = (Uint32)atlas->slot_capacity - 1;
+        for (Uint32 i = (codepoint * 2654435761u) & mask; atlas->slots[i] != 0; i = (i + 1) & mask) {
+            if (atlas->glyphs[atlas->slots[i] - 1].codepoint == codepoint) return atlas->slots[i] - 1;
+        }
+    }
+
+    SDL_Surface *rendered = TTF_RenderUTF8_Solid(atlas->font, utf8_char, atlas->color);
+    if (!rendered) {
+        fprintf(stderr, "Error loading text surface (text '%s'): %s\n", utf8_char, TTF_GetError());
+        return -1;
+    }
+    SDL_Surface *surface = SDL_ConvertSurfaceFormat(rendered, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(rendered);
+    if (!surface) {
+        fprintf(stderr, "Error converting glyph surface: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    if (surface->w + 2 * GLYPH_ATLAS_PADDING > GLYPH_ATLAS_SIZE || surface->h + 2 * GLYPH_ATLAS_PADDING > GLYPH_ATLAS_SIZE) {
+        fprintf(stderr, "Glyph '%s' (%dx%d) does not fit a %d px atlas page\n", utf8_char, surface->w, surface->h, GLYPH_ATLAS_SIZE);
+        SDL_FreeSurface(surface);
+        return -1;
+    }
+
+    if (atlas->glyph_count >= atlas->glyph_capacity) {
+        int capacity = atlas->glyph_capacity ? atlas->glyph_capacity * 2 : 128;
+        Glyph *glyphs = realloc(atlas->glyphs, sizeof(Glyph) * capacity);
+        if (!glyphs) {
+            SDL_FreeSurface(surface);
+            return -1;
+        }
+        atlas->glyphs = glyphs;
+        atlas->glyph_capacity = capacity;
+    }
+
+    // tabela com no máximo metade ocupada; reconstruída ao crescer:
+    int *slots = atlas->slots;
+    int slot_capacity = atlas->slot_capacity;
+    if ((atlas->glyph_count + 1) * 2 > slot_capacity) {
+        slot_capacity = slot_capacity ? slot_capacity * 2 : 256;
+        slots = calloc(slot_capacity, sizeof(int));
+        if (!slots) {
+            SDL_FreeSurface(surface);
+            return -1;
+        }
+    }
+
+    // página cheia: os glifos já colocados continuam onde estão e os novos vão para uma página nova.
+    SDL_Rect rect;
+    if (!glyph_atlas_place(atlas, surface->w, surface->h, &rect) && (!glyph_atlas_add_page(atlas) || !glyph_atlas_place(atlas, surface->w, surface->h, &rect))) {
+        if (slots != atlas->slots) free(slots);
+        SDL_FreeSurface(surface);
+        return -1;
+    }
+    int page = atlas->page_count - 1;
+    SDL_Texture *texture = resource_get(atlas->pages[page]);
+    if (texture) SDL_UpdateTexture(texture, &rect, surface->pixels, surface->pitch);
+    SDL_FreeSurface(surface);
+
+    int index = atlas->glyph_count++;
+    atlas->glyphs[index] = (Glyph){codepoint, page, rect};
+
+    if (slots != atlas->slots) {
+        free(atlas->slots);
+        atlas->slots = slots;
+        atlas->slot_capacity = slot_capacity;
+        Uint32 mask = (Uint32)atlas->slot_capacity - 1;
+        for (int i = 0; i < atlas->glyph_count; i++) {
+            Uint32 slot = (atlas->glyphs[i].codepoint * 2654435761u) & mask;
+            while (atlas->slots[slot] != 0) slot = (slot + 1) & mask;
+            atlas->slots[slot] = i + 1;
+        }
+    }
+    else {
+        Uint32 mask = (Uint32)atlas->slot_capacity - 1;
+        Uint32 slot = (codepoint * 2654435761u) & mask;
+        while (atlas->slots[slot] != 0) slot = (slot + 1) & mask;
+        atlas->slots[slot] = index + 1;
+    }
+
+    return index;
+}
+
+SDL_Texture *glyph_atlas_texture(GlyphAtlas *atlas, int page) {
+    return atlas && page >= 0 && page < atlas->page_count ? resource_get(atlas->pages[page]) : NULL;
+}
+
+void glyph_atlas_clear(void) {
+    for (int i = 0; i < glyph_atlas_count; i++) {
+        GlyphAtlas *atlas = glyph_atlases[i];
+        for (int page = 0; page < atlas->page_count; page++) {
+            SDL_Texture *texture = resource_get(atlas->pages[page]);
+            if (texture) resource_release(texture);
+        }
+        free(atlas->pages);
+        free(atlas->glyphs);
+        free(atlas->slots);
+        free(atlas);
+    }
+    free(glyph_atlases);
+    glyph_atlases = NULL;
+    glyph_atlas_count = 0;
+    glyph_atlas_capacity = 0;
+}
+
+void glyph_atlas_measure(GlyphAtlas *atlas, const char *utf8_text, int *w, int *h) {
+    *w = 0;
+    *h = atlas && atlas->font ? TTF_FontHeight(atlas->font) : 0;
+    if (!atlas || !utf8_text) return;
+
+    for (int byte = 0; utf8_text[byte] != '\0';) {
+        char utf8_buffer[5];
+        byte += utf8_copy_char(&utf8_text[byte], utf8_buffer);
+        int glyph = glyph_atlas_glyph(atlas, utf8_buffer);
+        if (glyph >= 0) *w += atlas->glyphs[glyph].rect.w;
+    }
+}
+
+void text_batch_begin(TextBatch *batch, GlyphAtlas *atlas) {
+    batch->atlas = atlas;
+    batch->quad_count = 0;
+}
+
+void text_batch_add(TextBatch *batch, const Glyph *glyph, int x, int y) {
+    if (batch->quad_count >= batch->quad_capacity) {
+        int capacity = batch->quad_capacity ? batch->quad_capacity * 2 : 256;
+        SDL_Vertex *vertices = realloc(batch->vertices, sizeof(SDL_Vertex) * 4 * capacity);
+        if (!vertices) return;
+        batch->vertices = vertices;
+        int *quad_pages = realloc(batch->quad_pages, sizeof(int) * capacity);
+        if (!quad_pages) return;
+        batch->quad_pages = quad_pages;
+        batch->quad_capacity = capacity;
+    }
+
+    const SDL_Rect *src = &glyph->rect;
+    batch->quad_pages[batch->quad_count] = glyph->page;
+
+    const float scale = 1.0f / GLYPH_ATLAS_SIZE;
+    float u0 = src->x * scale, v0 = src->y * scale;
+    float u1 = (src->x + src->w) * scale, v1 = (src->y + src->h) * scale;
+    float x0 = (float)x, y0 = (float)y;
+    float x1 = (float)(x + src->w), y1 = (float)(y + src->h);
+    SDL_Color color = {255, 255, 255, 255};
+
+    SDL_Vertex *vertex = &batch->vertices[batch->quad_count * 4];
+    vertex[0] = (SDL_Vertex){{x0, y0}, color, {u0, v0}};
+    vertex[1] = (SDL_Vertex){{x1, y0}, color, {u1, v0}};
+    vertex[2] = (SDL_Vertex){{x0, y1}, color, {u0, v1}};
+    vertex[3] = (SDL_Vertex){{x1, y1}, color, {u1, v1}};
+    batch->quad_count++;
+}
+
+void text_batch_string(TextBatch *batch, const char *utf8_text, int x, int y) {
+    if (!batch->atlas || !utf8_text) return;
+
+    for (int byte = 0; utf8_text[byte] != '\0';) {
+        char utf8_buffer[5];
+        byte += utf8_copy_char(&utf8_text[byte], utf8_buffer);
+        int glyph = glyph_atlas_glyph(batch->atlas, utf8_buffer);
+        if (glyph < 0) continue;
+
+        text_batch_add(batch, &batch->atlas->glyphs[glyph], x, y);
+        x += batch->atlas->glyphs[glyph].rect.w;
+    }
+}
+
+void text_batch_flush(SDL_Renderer *render, TextBatch *batch) {
+    if (!batch->atlas || batch->quad_count == 0 || render_queue.discard) {
+        batch->quad_count = 0;
+        return;
+    }
+
+    // uma chamada por sequência de quads da mesma página (quase sempre uma só), preservando a ordem.
+    // Os vértices são copiados para a fila, então o lote pode ser reutilizado logo em seguida:
+    text_stats.quads += batch->quad_count;
+    for (int first = 0; first < batch->quad_count;) {
+        int page = batch->quad_pages[first];
+        int last = first + 1;
+        while (last < batch->quad_count && batch->quad_pages[last] == page) last++;
+
+        SDL_Texture *texture = glyph_atlas_texture(batch->atlas, page);
+        if (texture) render_geometry(render, texture, &batch->vertices[first * 4], last - first);
+        first = last;
+    }
+    batch->quad_count = 0;
+}
+
+void text_batch_free(TextBatch *batch) {
+    free(batch->vertices);
+    free(batch->quad_pages);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void layer_cache_begin(LayerCache *cache) {
+    cache->layer_count = 0;
+}
+
+void layer_cache_add(LayerCache *cache, Sprite *sprite, const SDL_Rect *dst) {
+    if (!sprite || cache->layer_count >= LAYER_CACHE_MAX) return;
+
+    CachedLayer *layer = &cache->layers[cache->layer_count++];
+    layer->sprite = sprite;
+    layer->texture = sprite->texture;
+    layer->dst = *dst;
+}
+
+static bool layer_cache_changed(LayerCache *cache) {
+    if (!cache->valid || cache->layer_count != cache->drawn_count) return true;
+
+    for (int i = 0; i < cache->layer_count; i++) {
+        const CachedLayer *layer = &cache->layers[i];
+        const CachedLayer *drawn = &cache->drawn[i];
+        if (layer->sprite != drawn->sprite || layer->texture != drawn->texture || memcmp(&layer->dst, &drawn->dst, sizeof(SDL_Rect)) != 0) return true;
+    }
+
+    return false;
+}
+
+void layer_cache_draw(SDL_Renderer *render, LayerCache *cache) {
+    SDL_Rect screen = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    if (render_queue.discard) return;
+
+    if (!cache->target && SDL_RenderTargetSupported(render)) {
+        cache->target = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+        if (cache->target) {
+            SDL_SetTextureBlendMode(cache->target, SDL_BLENDMODE_NONE);
+            resource_register(cache->target, RESOURCE_TEXTURE);
+            resource_name(cache->target, "layer cache target");
+        }
+        cache->valid = false;
+    }
+
+    // SEM ALVO DE RENDERIZAÇÃO, AS CAMADAS SÃO DESENHADAS DIRETO, COMO ANTES:
+    if (!cache->target) {
+        for (int i = 0; i < cache->layer_count; i++) {
+            render_sprite(render, cache->layers[i].sprite, &cache->layers[i].dst);
+        }
+        return;
+    }
+
+    if (layer_cache_changed(cache)) {
+        // O que já está na fila vai para a tela antes da troca de alvo, e a recomposição é imediata.
+        render_queue_flush(render);
+        render_queue.immediate = true;
+        SDL_SetRenderTarget(render, cache->target);
+        SDL_SetRenderDrawColor(render, 0, 0, 0, 255);
+        SDL_RenderClear(render);
+        for (int i = 0; i < cache->layer_count; i++) {
+            render_sprite(render, cache->layers[i].sprite, &cache->layers[i].dst);
+        }
+        SDL_SetRenderTarget(render, NULL);
+        render_queue.immediate = false;
+        render_queue.applied_valid = false;
+
+        // a textura pode ter mudado durante o desenho (residência), então a chave é lida de novo:
+        for (int i = 0; i < cache->layer_count; i++) {
+            cache->layers[i].texture = cache->layers[i].sprite->texture;
+        }
+        memcpy(cache->drawn, cache->layers, sizeof(CachedLayer) * cache->layer_count);
+        cache->drawn_count = cache->layer_count;
+        cache->valid = true;
+        cache->recomposed++;
+    }
+    else {
+        cache->reused++;
+    }
+
+    render_queue_copy(render, cache->target, NULL, &(SDL_FRect){screen.x, screen.y, screen.w, screen.h}, NULL, 0.0, SDL_FLIP_NONE, 255);
+}
+
+void layer_cache_invalidate(LayerCache *cache) {
+    cache->valid = false;
+}
+
+void dirty_damage(DirtyRenderer *dirty, const SDL_Rect *rect) {
+    if (rect->w <= 0 || rect->h <= 0) return;
+
+    if (!dirty->damaged) {
+        dirty->damage = *rect;
+        dirty->damaged = true;
+        return;
+    }
+    SDL_UnionRect(&dirty->damage, rect, &dirty->damage);
+}
+
+void dirty_track(DirtyRenderer *dirty, int slot, Sprite *sprite, const SDL_Rect *rect) {
+    if (!dirty->enabled || slot < 0 || slot >= DIRTY_MAX_PROPS) return;
+
+    DirtyProp *prop = &dirty->props[slot];
+    if (prop->sprite == sprite && (!sprite || memcmp(&prop->rect, rect, sizeof(SDL_Rect)) == 0)) return;
+
+    if (prop->sprite) dirty_damage(dirty, &prop->rect);
+    if (sprite) dirty_damage(dirty, rect);
+    prop->sprite = sprite;
+    prop->rect = *rect;
+}
+
+bool dirty_begin(SDL_Renderer *render, DirtyRenderer *dirty, int screen) {
+    if (!dirty->enabled) return true;
+    if (render_queue.discard) return false;
+
+    if (!dirty->backbuffer) {
+        if (SDL_RenderTargetSupported(render)) {
+            dirty->backbuffer = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+        }
+        if (!dirty->backbuffer) {
+            fprintf(stderr, "Dirty-rect mode disabled: no render target support (%s)\n", SDL_GetError());
+            dirty->enabled = false;
+            return true;
+        }
+        SDL_SetTextureBlendMode(dirty->backbuffer, SDL_BLENDMODE_NONE);
+        resource_register(dirty->backbuffer, RESOURCE_TEXTURE);
+        resource_name(dirty->backbuffer, "dirty-rect backbuffer");
+        dirty->full = true;
+    }
+
+    // TROCAR DE TELA INVALIDA O BACKBUFFER INTEIRO:
+    if (screen != dirty->screen) {
+        dirty->screen = screen;
+        dirty->full = true;
+    }
+
+    SDL_Rect screen_rect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    dirty->frames++;
+    if (!dirty->full && !(dirty->damaged && SDL_IntersectRect(&dirty->damage, &screen_rect, &dirty->clip))) {
+        dirty->damaged = false;
+        return false;
+    }
+    if (dirty->full) dirty->clip = screen_rect;
+
+    // o que vai para o backbuffer não pode ser reenviado para a tela depois:
+    render_queue_flush(render);
+    render_queue.replayable = false;
+    SDL_SetRenderTarget(render, dirty->backbuffer);
+    SDL_RenderSetClipRect(render, &dirty->clip);
+    dirty->repainted_pixels += (Uint64)dirty->clip.w * dirty->clip.h;
+    dirty->full = false;
+    dirty->damaged = false;
+    dirty->active = true;
+    return true;
+}
+
+void dirty_clear(SDL_Renderer *render, DirtyRenderer *dirty) {
+    // SDL_RenderClear ignora o clip, então no modo sujo só a região danificada é preenchida:
+    if (dirty->active) render_fill_rect(render, &dirty->clip);
+    else render_clear(render);
+}
+
+void dirty_end(SDL_Renderer *render, DirtyRenderer *dirty) {
+    if (!dirty->enabled || render_queue.discard) return;
+
+    if (dirty->active) {
+        render_queue_flush(render);
+        SDL_RenderSetClipRect(render, NULL);
+        SDL_SetRenderTarget(render, NULL);
+        dirty->active = false;
+    }
+
+    SDL_FRect screen_rect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    render_queue_copy(render, dirty->backbuffer, NULL, &screen_rect, NULL, 0.0, SDL_FLIP_NONE, 255);
+}
+
+void dirty_invalidate(DirtyRenderer *dirty) {
+    dirty->full = true;
+}
+
+void cull_stats_frame(void) {
+    cull_stats.last = cull_stats.frame;
+    cull_stats.total_culled += cull_stats.frame.culled;
+    cull_stats.total_clipped += cull_stats.frame.clipped;
+    cull_stats.frames++;
+    memset(&cull_stats.frame, 0, sizeof(cull_stats.frame));
+}
+
+int cull_overlay(SDL_Renderer *render, GlyphAtlas *atlas, int x, int y) {
+    if (!atlas) return y;
+
+    char line[96];
+    snprintf(line, sizeof(line), "Sprites: %d drawn  %d clipped  %d culled", cull_stats.last.drawn, cull_stats.last.clipped, cull_stats.last.culled);
+    text_batch_begin(&text_batch, atlas);
+    text_batch_string(&text_batch, line, x, y);
+    text_batch_flush(render, &text_batch);
+    return y + (atlas->font ? TTF_FontLineSkip(atlas->font) : 16);
+}
+
+void render_queue_begin(bool discard) {
+    render_queue.tick++;
+    if (render_queue.track_count * 2 > RENDER_TRACK_SLOTS) render_queue_prune_tracks();
+    render_queue.discard = discard;
+    render_queue.layer = RENDER_LAYER_BACKGROUND;
+    render_queue.depth = RENDER_DEPTH_ORDERED;
+
+    // Ticks sem apresentação só atualizam as posições rastreadas; nada é gravado.
+    if (discard) return;
+
+    render_queue.count = 0;
+    render_queue.flushed = 0;
+    render_queue.vertex_count = 0;
+    render_queue.sequence = 0;
+    render_queue.replayable = true;
+
+    // o estado aplicado é conferido de novo uma vez por quadro, caso algo fora da fila o tenha mudado:
+    render_queue.applied_valid = false;
+    render_queue.alpha_texture = NULL;
+
+    render_queue.last = render_queue.frame;
+    render_queue.total_commands += render_queue.frame.commands;
+    render_queue.total_draw_calls += render_queue.frame.draw_calls;
+    render_queue.total_elided += render_queue.frame.elided;
+    render_queue.frames++;
+    memset(&render_queue.frame, 0, sizeof(render_queue.frame));
+}
+
+void render_queue_layer(int layer) {
+    render_queue.layer = layer;
+}
+
+void render_queue_depth(int depth) {
+    render_queue.depth = depth;
+}
+
+void render_queue_group_begin(void) {
+    // todo o grupo divide a profundidade do primeiro comando e passa a ser ordenado só por estado:
+    render_queue.depth = RENDER_DEPTH_GROUP;
+    render_queue.group_depth = render_queue.sequence;
+}
+
+void render_queue_group_end(void) {
+    render_queue.depth = RENDER_DEPTH_ORDERED;
+}
+
+static RenderCommand *render_queue_push(int type, SDL_Texture *texture) {
+    if (render_queue.count >= render_queue.capacity) {
+        int capacity = render_queue.capacity ? render_queue.capacity * 2 : 512;
+        RenderCommand *commands = realloc(render_queue.commands, sizeof(RenderCommand) * capacity);
+        if (!commands) {
+            render_queue.frame.dropped++;
+            return NULL;
+        }
+        render_queue.commands = commands;
+        render_queue.capacity = capacity;
+    }
+
+    Uint32 depth;
+    if (render_queue.depth == RENDER_DEPTH_ORDERED) depth = render_queue.sequence;
+    else if (render_queue.depth == RENDER_DEPTH_GROUP) depth = render_queue.group_depth;
+    else depth = (Uint32)(render_queue.depth + RENDER_DEPTH_BIAS);
+
+    // Estado: textura (ou modo de mistura dos preenchimentos), usado só entre comandos de mesma profundidade.
+    Uint32 state = texture ? (Uint32)(((uintptr_t)texture >> 4) * 2654435761u) >> 16 : (Uint32)render_queue.blend;
+
+    RenderCommand *command = &render_queue.commands[render_queue.count++];
+    memset(command, 0, sizeof(*command));
+    command->type = type;
+    command->texture = texture;
+    command->key = ((Uint64)(render_queue.layer & 0xFF) << 56) | ((Uint64)(depth & 0xFFFFFF) << 32) | ((Uint64)(state & 0xFFFF) << 16) | (render_queue.sequence & 0xFFFF);
+    render_queue.sequence++;
+    render_queue.frame.commands++;
+    return command;
+}
+
+void render_queue_copy(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, const SDL_FRect *from, double angle, SDL_RendererFlip flip, Uint8 alpha) {
+    SDL_FRect full = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    if (!dst) dst = &full;
+    if (render_queue.discard) return;
+
+    if (render_queue.immediate) {
+        SDL_SetTextureAlphaMod(texture, alpha);
+        if (angle != 0.0 || flip != SDL_FLIP_NONE) SDL_RenderCopyExF(render, texture, src, dst, angle, NULL, flip);
+        else SDL_RenderCopyF(render, texture, src, dst);
+        render_queue.alpha_texture = NULL;
+        return;
+    }
+
+    RenderCommand *command = render_queue_push(RENDER_COPY, texture);
+    if (!command) return;
+    command->has_src = src != NULL;
+    if (src) command->src = *src;
+    command->dst = *dst;
+    command->lerp = from != NULL;
+    if (from) command->from = *from;
+    command->angle = angle;
+    command->flip = flip;
+    command->color.a = alpha;
+}
+
+void render_set_color(SDL_Renderer *render, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    render_queue.color = (SDL_Color){r, g, b, a};
+    if (render_queue.immediate) {
+        SDL_SetRenderDrawColor(render, r, g, b, a);
+        render_queue.applied_valid = false;
+    }
+}
+
+void render_set_blend(SDL_Renderer *render, SDL_BlendMode blend) {
+    render_queue.blend = blend;
+    if (render_queue.immediate) {
+        SDL_SetRenderDrawBlendMode(render, blend);
+        render_queue.applied_valid = false;
+    }
+}
+
+void render_fill_rect(SDL_Renderer *render, const SDL_Rect *rect) {
+    if (render_queue.discard) return;
+
+    SDL_FRect frect = rect ? (SDL_FRect){rect->x, rect->y, rect->w, rect->h} : (SDL_FRect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    if (render_queue.immediate) {
+        SDL_RenderFillRectF(render, &frect);
+        return;
+    }
+
+    RenderCommand *command = render_queue_push(RENDER_FILL, NULL);
+    if (!command) return;
+    command->dst = frect;
+    command->color = render_queue.color;
+    command->blend = render_queue.blend;
+}
+
+void render_fill_rects(SDL_Renderer *render, const SDL_Rect *rects, int count) {
+    for (int i = 0; i < count; i++) {
+        render_fill_rect(render, &rects[i]);
+    }
+}
+
+void render_clear(SDL_Renderer *render) {
+    if (render_queue.discard) return;
+    if (render_queue.immediate) {
+        SDL_RenderClear(render);
+        return;
+    }
+
+    // Tudo o que foi gravado antes seria apagado, então nem chega a ser enviado.
+    render_queue.frame.dropped += render_queue.count - render_queue.flushed;
+    render_queue.count = render_queue.flushed;
+
+    RenderCommand *command = render_queue_push(RENDER_CLEAR, NULL);
+    if (!command) return;
+    command->key = 0;
+    command->color = render_queue.color;
+    command->blend = render_queue.blend;
+}
+
+void render_geometry(SDL_Renderer *render, SDL_Texture *texture, const SDL_Vertex *vertices, int quad_count) {
+    if (quad_count <= 0 || render_queue.discard) return;
+
+    if (render_queue.vertex_count + quad_count * 4 > render_queue.vertex_capacity) {
+        int capacity = render_queue.vertex_capacity;
+        while (render_queue.vertex_count + quad_count * 4 > capacity) {
+            capacity = capacity ? capacity * 2 : 2048;
+        }
+        SDL_Vertex *grown = realloc(render_queue.vertices, sizeof(SDL_Vertex) * capacity);
+        if (!grown) {
+            render_queue.frame.dropped++;
+            return;
+        }
+        render_queue.vertices = grown;
+        render_queue.vertex_capacity = capacity;
+    }
+    if (quad_count > render_queue.index_quads) {
+        int old_quads = render_queue.index_quads;
+        int quads = quad_count > old_quads * 2 ? quad_count : old_quads * 2;
+        int *indices = realloc(render_queue.indices, sizeof(int) * 6 * quads);
+        if (!indices) {
+            render_queue.frame.dropped++;
+            return;
+        }
+        render_queue.indices = indices;
+        render_queue.index_quads = quads;
+
+        // os índices só dependem da posição do quad, então são gerados uma vez por capacidade:
+        for (int i = old_quads; i < render_queue.index_quads; i++) {
+            int *index = &render_queue.indices[i * 6];
+            index[0] = i * 4;
+            index[1] = i * 4 + 1;
+            index[2] = i * 4 + 2;
+            index[3] = i * 4 + 2;
+            index[4] = i * 4 + 1;
+            index[5] = i * 4 + 3;
+        }
+    }
+
+    memcpy(&render_queue.vertices[render_queue.vertex_count], vertices, sizeof(SDL_Vertex) * quad_count * 4);
+    if (render_queue.immediate) {
+        render_queue_submit_geometry(render, texture, render_queue.vertex_count, quad_count);
+        return;
+    }
+
+    RenderCommand *command = render_queue_push(RENDER_GEOMETRY, texture);
+    if (!command) return;
+    command->first_vertex = render_queue.vertex_count;
+    command->quad_count = quad_count;
+    render_queue.vertex_count += quad_count * 4;
+}
+
+static void render_queue_submit_geometry(SDL_Renderer *render, SDL_Texture *texture, int first_vertex, int quad_count) {
+    const SDL_Vertex *vertices = &render_queue.vertices[first_vertex];
+    if (SDL_RenderGeometry(render, texture, vertices, quad_count * 4, render_queue.indices, quad_count * 6) == 0) {
+        text_stats.draw_calls++;
+        render_queue.frame.draw_calls++;
+        return;
+    }
+
+    // RENDERIZADORES SEM SUPORTE A GEOMETRIA VOLTAM PARA UM SDL_RenderCopy POR GLIFO:
+    int texture_w = GLYPH_ATLAS_SIZE, texture_h = GLYPH_ATLAS_SIZE;
+    SDL_QueryTexture(texture, NULL, NULL, &texture_w, &texture_h);
+    for (int i = 0; i < quad_count; i++) {
+        const SDL_Vertex *vertex = &vertices[i * 4];
+        SDL_Rect src = {(int)(vertex[0].tex_coord.x * texture_w + 0.5f), (int)(vertex[0].tex_coord.y * texture_h + 0.5f), (int)((vertex[3].tex_coord.x - vertex[0].tex_coord.x) * texture_w + 0.5f), (int)((vertex[3].tex_coord.y - vertex[0].tex_coord.y) * texture_h + 0.5f)};
+        SDL_FRect dst = {vertex[0].position.x, vertex[0].position.y, vertex[3].position.x - vertex[0].position.x, vertex[3].position.y - vertex[0].position.y};
+        SDL_RenderCopyF(render, texture, &src, &dst);
+    }
+    text_stats.draw_calls += quad_count;
+    render_queue.frame.draw_calls += quad_count;
+}
+
+static void render_queue_apply(SDL_Renderer *render, SDL_Color color, SDL_BlendMode blend) {
+    SDL_Color applied = render_queue.applied_color;
+    bool valid = render_queue.applied_valid;
+
+    if (valid && render_queue.applied_blend == blend) {
+        render_queue.frame.elided++;
+    }
+    else {
+        SDL_SetRenderDrawBlendMode(render, blend);
+        render_queue.applied_blend = blend;
+        render_queue.frame.state_changes++;
+    }
+
+    if (valid && applied.r == color.r && applied.g == color.g && applied.b == color.b && applied.a == color.a) {
+        render_queue.frame.elided++;
+    }
+    else {
+        SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
+        render_queue.applied_color = color;
+        render_queue.frame.state_changes++;
+    }
+    render_queue.applied_valid = true;
+}
+
+int render_command_cmp(const void *pa, const void *pb) {
+    const RenderCommand *a = (const RenderCommand *)pa;
+    const RenderCommand *b = (const RenderCommand *)pb;
+
+    if (a->key < b->key) return -1;
+    if (a->key > b->key) return 1;
+
+    return 0;
+}
+
+static void render_queue_submit(SDL_Renderer *render, int first, int last) {
+    SDL_FRect fills[RENDER_FILL_RUN];
+    SDL_Texture *bound = NULL;
+    for (int i = first; i < last; i++) {
+        RenderCommand *command = &render_queue.commands[i];
+        if (command->texture && command->texture != bound) {
+            bound = command->texture;
+            render_queue.frame.binds++;
+        }
+        switch (command->type) {
+        case RENDER_CLEAR:
+            render_queue_apply(render, command->color, command->blend);
+            SDL_RenderClear(render);
+            render_queue.frame.draw_calls++;
+            break;
+        case RENDER_FILL: {
+            // preenchimentos seguidos com a mesma cor e mistura viram uma única chamada:
+            render_queue_apply(render, command->color, command->blend);
+            int run = 0;
+            fills[run++] = command->dst;
+            while (i + 1 < last && run < RENDER_FILL_RUN) {
+                RenderCommand *next = &render_queue.commands[i + 1];
+                if (next->type != RENDER_FILL || next->blend != command->blend || memcmp(&next->color, &command->color, sizeof(SDL_Color)) != 0) break;
+                fills[run++] = next->dst;
+                render_queue.frame.elided += 2;
+                i++;
+            }
+            SDL_RenderFillRectsF(render, fills, run);
+            render_queue.frame.draw_calls++;
+            break;
+        }
+        case RENDER_COPY: {
+            SDL_FRect dst = command->dst;
+            if (command->lerp) {
+                // posição entre o tick anterior e o atual, conforme o tempo que sobrou no acumulador:
+                float t = (float)sim_clock.alpha;
+                dst.x = command->from.x + (command->dst.x - command->from.x) * t;
+                dst.y = command->from.y + (command->dst.y - command->from.y) * t;
+                dst.w = command->from.w + (command->dst.w - command->from.w) * t;
+                dst.h = command->from.h + (command->dst.h - command->from.h) * t;
+            }
+            if (render_queue.alpha_texture == command->texture && render_queue.alpha == command->color.a) {
+                render_queue.frame.elided++;
+            }
+            else {
+                SDL_SetTextureAlphaMod(command->texture, command->color.a);
+                render_queue.alpha_texture = command->texture;
+                render_queue.alpha = command->color.a;
+                render_queue.frame.state_changes++;
+            }
+            if (command->angle != 0.0 || command->flip != SDL_FLIP_NONE) {
+                SDL_RenderCopyExF(render, command->texture, command->has_src ? &command->src : NULL, &dst, command->angle, NULL, command->flip);
+            }
+            else {
+                SDL_RenderCopyF(render, command->texture, command->has_src ? &command->src : NULL, &dst);
+            }
+            render_queue.frame.draw_calls++;
+            break;
+        }
+        case RENDER_GEOMETRY:
+            render_queue_submit_geometry(render, command->texture, command->first_vertex, command->quad_count);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void render_queue_flush(SDL_Renderer *render) {
+    if (render_queue.discard || render_queue.flushed == render_queue.count) return;
+
+    // Só o trecho ainda pendente é ordenado; o que já foi enviado fica guardado para reenvio.
+    RenderCommand *pending = &render_queue.commands[render_queue.flushed];
+    qsort(pending, render_queue.count - render_queue.flushed, sizeof(RenderCommand), render_command_cmp);
+    render_queue_submit(render, render_queue.flushed, render_queue.count);
+    render_queue.flushed = render_queue.count;
+}
+
+bool render_queue_replay(SDL_Renderer *render) {
+    if (!render_queue.replayable || render_queue.flushed == 0) return false;
+
+    // O quadro reenviado não entra nos contadores, que continuam descrevendo o quadro gravado.
+    RenderQueueStats stats = render_queue.frame;
+    Uint64 text_draw_calls = text_stats.draw_calls;
+    render_queue.applied_valid = false;
+    render_queue.alpha_texture = NULL;
+    render_queue_submit(render, 0, render_queue.flushed);
+    render_queue.frame = stats;
+    text_stats.draw_calls = text_draw_calls;
+    return true;
+}
+
+static RenderTrack *render_queue_find_track(const void *id) {
+    Uint32 slot = (Uint32)(((uintptr_t)id >> 3) * 2654435761u) % RENDER_TRACK_SLOTS;
+    for (int probe = 0; probe < RENDER_TRACK_SLOTS; probe++) {
+        RenderTrack *candidate = &render_queue.tracks[(slot + probe) % RENDER_TRACK_SLOTS];
+        if (candidate->id == id || candidate->id == NULL) return candidate;
+    }
+    return NULL;
+}
+
+static void render_queue_prune_tracks(void) {
+    // só o que foi desenhado no tick anterior ainda pode ser interpolado; o resto é reinserido fora da tabela.
+    static RenderTrack live[RENDER_TRACK_SLOTS];
+    int live_count = 0;
+    for (int i = 0; i < RENDER_TRACK_SLOTS; i++) {
+        const RenderTrack *track = &render_queue.tracks[i];
+        if (track->id && track->tick + 1 >= render_queue.tick) live[live_count++] = *track;
+    }
+
+    memset(render_queue.tracks, 0, sizeof(render_queue.tracks));
+    for (int i = 0; i < live_count; i++) {
+        *render_queue_find_track(live[i].id) = live[i];
+    }
+    render_queue.track_count = live_count;
+}
+
+static bool render_queue_track(const void *id, const SDL_FRect *dst, SDL_FRect *from) {
+    if (!id) return false;
+
+    RenderTrack *track = render_queue_find_track(id);
+    if (!track) return false;
+
+    if (track->id == NULL) {
+        *track = (RenderTrack){.id = id, .tick = render_queue.tick, .previous = *dst, .current = *dst, .draws = 1};
+        render_queue.track_count++;
+        return false;
+    }
+    if (track->tick != render_queue.tick) {
+        // só uma posição única do tick imediatamente anterior serve de origem:
+        bool continuous = track->tick + 1 == render_queue.tick && track->draws == 1;
+        track->previous = continuous ? track->current : *dst;
+        track->ambiguous = !continuous;
+        track->current = *dst;
+        track->tick = render_queue.tick;
+        track->draws = 1;
+    }
+    else {
+        // o mesmo retângulo desenhado duas vezes no tick (temporários reutilizados) não é interpolado:
+        track->draws++;
+        track->ambiguous = true;
+    }
+    if (track->ambiguous) return false;
+
+    *from = track->previous;
+    if (from->x == dst->x && from->y == dst->y && from->w == dst->w && from->h == dst->h) return false;
+
+    // saltos grandes são teletransportes (troca de cena, reset) e vão direto para o destino:
+    return fabsf(from->x - dst->x) <= RENDER_LERP_MAX_STEP && fabsf(from->y - dst->y) <= RENDER_LERP_MAX_STEP;
+}
+
+void render_queue_forget(const void *id) {
+    if (!id) return;
+
+    // Slot reaproveitado por outro objeto: a posição antiga vira ambígua e o próximo desenho não interpola.
+    RenderTrack *track = render_queue_find_track(id);
+    if (track && track->id == id) track->draws = 2;
+}
+
+void render_queue_set_state(int state) {
+    if (state == render_queue.track_state) return;
+
+    // Na troca de estado os endereços passam a ser de outros objetos, então nada é interpolado a partir do estado anterior.
+    memset(render_queue.tracks, 0, sizeof(render_queue.tracks));
+    render_queue.track_count = 0;
+    render_queue.track_state = state;
+}
+
+int sim_clock_advance(SimClock *clock, double elapsed) {
+    // Travadas longas não viram uma rajada de ticks; o tempo descartado fica registrado.
+    if (elapsed > SIM_MAX_FRAME) {
+        clock->dropped += elapsed - SIM_MAX_FRAME;
+        clock->stalls++;
+        elapsed = SIM_MAX_FRAME;
+    }
+
+    clock->accumulator += elapsed;
+    clock->pending = (int)(clock->accumulator / SIM_DT);
+    clock->accumulator -= clock->pending * SIM_DT;
+    clock->alpha = clock->accumulator / SIM_DT;
+    clock->frames++;
+    return clock->pending;
+}
+
+void perf_mark(PerfHud *perf) {
+    if (perf->frequency == 0) perf->frequency = SDL_GetPerformanceFrequency();
+    perf->mark = SDL_GetPerformanceCounter();
+
+    // cada volta do laço começa do zero; uma volta que não fecha tick nem quadro não é atribuída a ninguém.
+    memset(perf->pass, 0, sizeof(perf->pass));
+}
+
+void perf_phase(PerfHud *perf, int phase) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    double elapsed = (double)(now - perf->mark) / perf->frequency;
+    perf->phase[phase] += elapsed;
+    perf->pass[phase] += elapsed;
+    perf->mark = now;
+}
+
+void perf_tick_end(PerfHud *perf, int state) {
+    if (state >= 0 && state < GAME_STATE_COUNT) {
+        perf->state_total[state][PERF_INPUT] += perf->pass[PERF_INPUT];
+        perf->state_total[state][PERF_UPDATE] += perf->pass[PERF_UPDATE];
+        perf->state_ticks[state]++;
+    }
+    perf->pass[PERF_INPUT] = perf->pass[PERF_UPDATE] = 0.0;
+}
+
+void perf_frame_end(PerfHud *perf, int state, bool replay) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (perf->frame_start != 0) {
+        perf->history[perf->history_next] = (double)(now - perf->frame_start) / perf->frequency;
+        perf->history_next = (perf->history_next + 1) % PERF_HISTORY;
+        if (perf->history_count < PERF_HISTORY) perf->history_count++;
+    }
+    perf->frame_start = now;
+
+    // Quadros reenviados não rodam atualização e iriam puxar as médias para baixo, então têm totais próprios.
+    if (state >= 0 && state < GAME_STATE_COUNT && replay) {
+        for (int i = 0; i < PERF_PHASE_COUNT; i++) {
+            perf->replay_total[state][i] += perf->pass[i];
+        }
+        perf->replay_frames[state]++;
+    }
+    else if (state >= 0 && state < GAME_STATE_COUNT) {
+        perf->state_total[state][PERF_SUBMIT] += perf->pass[PERF_SUBMIT];
+        perf->state_total[state][PERF_PRESENT] += perf->pass[PERF_PRESENT];
+        perf->state_frames[state]++;
+    }
+    memset(perf->phase, 0, sizeof(perf->phase));
+    memset(perf->pass, 0, sizeof(perf->pass));
+}
+
+static double perf_average_ms(const PerfHud *perf, int state, int phase) {
+    Uint64 count = phase == PERF_INPUT || phase == PERF_UPDATE ? perf->state_ticks[state] : perf->state_frames[state];
+    return count ? 1000.0 * perf->state_total[state][phase] / count : 0.0;
+}
+
+int double_cmp(const void *pa, const void *pb) {
+    double a = *(const double *)pa;
+    double b = *(const double *)pb;
+
+    if (a < b) return -1;
+    if (a > b) return 1;
+
+    return 0;
+}
+
+static double perf_percentile(const double *sorted, int count, double percentile) {
+    if (count == 0) return 0.0;
+
+    int index = (int)ceil(percentile / 100.0 * count) - 1;
+    if (index < 0) index = 0;
+    if (index >= count) index = count - 1;
+    return sorted[index];
+}
+
+int perf_overlay(SDL_Renderer *render, GlyphAtlas *atlas, int x, int y) {
+    if (!atlas) return y;
+
+    int line_height = atlas->font ? TTF_FontLineSkip(atlas->font) : 16;
+    char line[128];
+    SDL_Rect background = {x - 4, y - 2, PERF_HISTORY + 8, line_height * (4 + GAME_STATE_COUNT) + PERF_GRAPH_HEIGHT + 10};
+    SDL_BlendMode previous_blend = render_queue.blend;
+    render_set_color(render, 0, 0, 0, 200);
+    render_set_blend(render, SDL_BLENDMODE_BLEND);
+    render_fill_rect(render, &background);
+    render_set_blend(render, previous_blend);
+
+    double sorted[PERF_HISTORY];
+    int count = perf_hud.history_count;
+    memcpy(sorted, perf_hud.history, sizeof(double) * count);
+    qsort(sorted, count, sizeof(double), double_cmp);
+
+    text_batch_begin(&text_batch, atlas);
+    snprintf(line, sizeof(line), "Frame p50 %.2f  p95 %.2f ms", 1000.0 * perf_percentile(sorted, count, 50), 1000.0 * perf_percentile(sorted, count, 95));
+    text_batch_string(&text_batch, line, x, y);
+    y += line_height;
+    snprintf(line, sizeof(line), "p99 %.2f  max %.2f ms", 1000.0 * perf_percentile(sorted, count, 99), count ? 1000.0 * sorted[count - 1] : 0.0);
+    text_batch_string(&text_batch, line, x, y);
+    y += line_height;
+    snprintf(line, sizeof(line), "Draws %d  binds %d", render_queue.last.draw_calls, render_queue.last.binds);
+    text_batch_string(&text_batch, line, x, y);
+    y += line_height;
+
+    // MÉDIAS POR ESTADO EM MS: ENTRADA / ATUALIZAÇÃO E GRAVAÇÃO POR TICK, ENVIO / PRESENT POR QUADRO SIMULADO:
+    text_batch_string(&text_batch, "ms: input/update per tick, submit/present", x, y);
+    y += line_height;
+    for (int state = 0; state < GAME_STATE_COUNT; state++) {
+        snprintf(line, sizeof(line), "%s%.13s %.1f/%.1f/%.1f/%.1f", state == registry.state ? ">" : " ", game_state_names[state],
+                 perf_average_ms(&perf_hud, state, PERF_INPUT), perf_average_ms(&perf_hud, state, PERF_UPDATE), perf_average_ms(&perf_hud, state, PERF_SUBMIT), perf_average_ms(&perf_hud, state, PERF_PRESENT));
+        text_batch_string(&text_batch, line, x, y);
+        y += line_height;
+    }
+    text_batch_flush(render, &text_batch);
+
+    // GRÁFICO DOS ÚLTIMOS QUADROS (BARRAS ACIMA DO ORÇAMENTO EM VERMELHO; A LINHA É O ORÇAMENTO):
+    y += 4;
+    const double budget = 1.0 / SIM_TICK_RATE;
+    SDL_Rect bars[PERF_HISTORY];
+    for (int pass = 0; pass < 2; pass++) {
+        int bar_count = 0;
+        for (int i = 0; i < count; i++) {
+            double frame = perf_hud.history[(perf_hud.history_next - count + i + PERF_HISTORY) % PERF_HISTORY];
+            if ((frame > budget) != (pass == 1)) continue;
+
+            int h = (int)(frame / (2.0 * budget) * PERF_GRAPH_HEIGHT);
+            if (h > PERF_GRAPH_HEIGHT) h = PERF_GRAPH_HEIGHT;
+            if (h < 1) h = 1;
+            bars[bar_count++] = (SDL_Rect){x + i, y + PERF_GRAPH_HEIGHT - h, 1, h};
+        }
+        if (pass == 0) render_set_color(render, 8, 207, 21, 255);
+        else render_set_color(render, 168, 24, 13, 255);
+        render_fill_rects(render, bars, bar_count);
+    }
+    render_set_color(render, 255, 255, 255, 255);
+    render_fill_rect(render, &(SDL_Rect){x, y + PERF_GRAPH_HEIGHT / 2, PERF_HISTORY, 1});
+
+    return y + PERF_GRAPH_HEIGHT + 4;
+}
+
+void trace_init(bool enabled, bool dump_on_exit) {
+    tracer.tls = SDL_TLSCreate();
+    tracer.origin = SDL_GetPerformanceCounter();
+    tracer.dump_on_exit = dump_on_exit;
+    tracer.enabled = enabled && tracer.tls != 0;
+    trace_name_thread("main");
+}
+
+static TraceRing *trace_ring(void) {
+    TraceRing *ring = SDL_TLSGet(tracer.tls);
+    if (ring) return ring == &tracer.overflow ? NULL : ring;
+
+    // cada thread reserva o seu anel uma única vez; depois disso só ela escreve nele.
+    // Sem anel livre a thread fica marcada, para não reservar de novo a cada zona:
+    int index = SDL_AtomicAdd(&tracer.ring_count, 1);
+    if (index >= TRACE_MAX_THREADS) {
+        SDL_TLSSet(tracer.tls, &tracer.overflow, NULL);
+        return NULL;
+    }
+
+    ring = &tracer.rings[index];
+    ring->thread = SDL_ThreadID();
+    if (!ring->name) ring->name = "worker";
+    SDL_TLSSet(tracer.tls, ring, NULL);
+    return ring;
+}
+
+// os eventos só são alocados na primeira zona gravada, então nomear threads com o trace desligado não custa o anel:
+static bool trace_ring_events(TraceRing *ring) {
+    if (ring->events) return true;
+
+    ring->events = calloc(TRACE_RING_SIZE, sizeof(TraceEvent));
+    if (!ring->events) return false;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->ready, 1);
+    return true;
+}
+
+void trace_name_thread(const char *name) {
+    if (!tracer.tls) return;
+
+    TraceRing *ring = trace_ring();
+    if (ring) ring->name = name;
+}
+
+Uint64 trace_begin(void) {
+    if (!tracer.enabled) return 0;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (hardware_counters.enabled) counters_begin(&hardware_counters, start);
+    return start;
+}
+
+void trace_end(const char *name, Uint64 start) {
+    if (!tracer.enabled || start == 0) return;
+    if (hardware_counters.enabled) counters_end(&hardware_counters, name, start);
+
+    TraceRing *ring = trace_ring();
+    if (!ring || !trace_ring_events(ring)) return;
+
+    // Um único escritor por anel: o evento é escrito antes de o índice ser publicado.
+    int head = SDL_AtomicGet(&ring->head);
+    TraceEvent *event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    event->name = name;
+    event->start = start;
+    event->end = SDL_GetPerformanceCounter();
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->head, head + 1);
+}
+
+void trace_scope_end(TraceScope *scope) {
+    trace_end(scope->name, scope->start);
+}
+
+bool trace_dump(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Error writing trace '%s'\n", path);
+        return true;
+    }
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    int ring_count = SDL_min(SDL_AtomicGet(&tracer.ring_count), TRACE_MAX_THREADS);
+    int written = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int r = 0; r < ring_count; r++) {
+        TraceRing *ring = &tracer.rings[r];
+        if (!SDL_AtomicGet(&ring->ready)) continue;
+        SDL_MemoryBarrierAcquire();
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":", written ? ",\n" : "", (unsigned long)ring->thread);
+        trace_write_string(file, ring->name);
+        fprintf(file, "}}");
+        written++;
+
+        // os eventos mais antigos de outras threads podem estar sendo sobrescritos agora, então
+        // a janela lida deixa uma folga atrás do índice publicado:
+        int head = SDL_AtomicGet(&ring->head);
+        int count = SDL_min(head, TRACE_RING_SIZE - (ring->thread == SDL_ThreadID() ? 0 : TRACE_RING_SLACK));
+        for (int i = head - count; i < head; i++) {
+            const TraceEvent *event = &ring->events[i & (TRACE_RING_SIZE - 1)];
+            if (!event->name || event->end < event->start) continue;
+
+            fprintf(file, ",\n{\"name\":");
+            trace_write_string(file, event->name);
+            fprintf(file, ",\"cat\":\"zone\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu}",
+                    (event->start - tracer.origin) * 1e6 / frequency, (event->end - event->start) * 1e6 / frequency, (unsigned long)ring->thread);
+            written++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("Trace: %d events written to %s\n", written, path);
+    return false;
+}
+
+void trace_dump_next(void) {
+    // o primeiro F8 liga a gravação; os seguintes despejam o que foi gravado desde então.
+    if (!tracer.enabled) {
+        if (!tracer.tls) return;
+        tracer.enabled = true;
+        printf("Trace: recording, press F8 again to write it\n");
+        return;
+    }
+
+    char path[PATH_LENGTH];
+    snprintf(path, sizeof(path), TRACE_DUMP_FORMAT, ++tracer.dumps);
+    trace_dump(path);
+}
+
+void trace_shutdown(void) {
+    if (tracer.enabled && tracer.dump_on_exit) trace_dump(TRACE_EXIT_PATH);
+    tracer.enabled = false;
+
+    // as threads de trabalho já terminaram aqui, então os anéis podem ser liberados:
+    int ring_count = SDL_min(SDL_AtomicGet(&tracer.ring_count), TRACE_MAX_THREADS);
+    for (int r = 0; r < ring_count; r++) {
+        free(tracer.rings[r].events);
+        tracer.rings[r].events = NULL;
+        SDL_AtomicSet(&tracer.rings[r].ready, 0);
+    }
+}
+
+void counters_init(HardwareCounters *counters) {
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        counters->fds[c] = -1;
+        counters->slot[c] = -1;
+    }
+    counters->leader = -1;
+    if (!counters->requested) return;
+
+#ifdef __linux__
+    static const struct { Uint32 type; Uint64 config; } events[COUNTER_COUNT] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+
+    // Só o espaço de usuário por padrão: com o kernel, o read() de cada zona conta a si mesmo.
+    // Com --perf-counters-kernel e kernel.perf_event_paranoid >= 2, a segunda tentativa volta para só usuário.
+    for (int attempt = 0; attempt < 2 && counters->opened == 0; attempt++) {
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[c].type;
+            attr.config = events[c].config;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.disabled = counters->leader < 0;
+            attr.exclude_kernel = !counters->kernel;
+            attr.exclude_hv = 1;
+
+            // todos no mesmo grupo: são agendados juntos e lidos com um único read()
+            int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, counters->leader, 0);
+            if (fd < 0) continue;
+            if (counters->leader < 0) counters->leader = fd;
+            counters->fds[c] = fd;
+            counters->slot[c] = counters->opened++;
+        }
+        if (counters->opened > 0 || !counters->kernel) break;
+        counters->kernel = false;
+    }
+    if (counters->opened == 0) {
+        fprintf(stderr, "Error opening hardware counters: %s\n", strerror(errno));
+        return;
+    }
+
+    ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    counters->thread = SDL_ThreadID();
+    counters->enabled = true;
+#else
+    fprintf(stderr, "Hardware counters are only available on Linux\n");
+#endif
+}
+
+static bool counters_read(HardwareCounters *counters, CounterMark *mark) {
+#ifdef __linux__
+    // formato do grupo: quantidade, tempo habilitado, tempo rodando e um valor por contador.
+    Uint64 buffer[3 + COUNTER_COUNT];
+    if (read(counters->leader, buffer, sizeof(buffer)) < (ssize_t)(sizeof(Uint64) * (3 + counters->opened))) return false;
+
+    mark->time_enabled = buffer[1];
+    mark->time_running = buffer[2];
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        mark->values[c] = counters->slot[c] >= 0 ? buffer[3 + counters->slot[c]] : 0;
+    }
+    return true;
+#else
+    (void)counters;
+    (void)mark;
+    return false;
+#endif
+}
+
+void counters_begin(HardwareCounters *counters, Uint64 start) {
+    if (SDL_ThreadID() != counters->thread) return;
+    if (counters->depth >= COUNTER_STACK) {
+        counters->dropped++;
+        return;
+    }
+
+    CounterMark *mark = &counters->stack[counters->depth];
+    if (!counters_read(counters, mark)) return;
+    mark->start = start;
+    counters->depth++;
+}
+
+void counters_end(HardwareCounters *counters, const char *name, Uint64 start) {
+    if (SDL_ThreadID() != counters->thread || counters->depth == 0) return;
+
+    CounterMark now;
+    if (!counters_read(counters, &now)) return;
+
+    // Zonas abertas à mão que nunca foram fechadas ficam acima da marca desta e são descartadas junto.
+    int depth = counters->depth;
+    while (depth > 0 && counters->stack[depth - 1].start != start) depth--;
+    if (depth == 0) return;
+    counters->depth = depth - 1;
+    const CounterMark *mark = &counters->stack[depth - 1];
+
+    int zone = 0;
+    while (zone < counters->zone_count && counters->zones[zone].name != name) zone++;
+    if (zone == counters->zone_count) {
+        if (zone >= COUNTER_ZONES) {
+            counters->dropped++;
+            return;
+        }
+        counters->zones[counters->zone_count++].name = name;
+    }
+
+    // Com mais contadores que registradores o grupo é multiplexado: a contagem da zona é estendida
+    // pela fração do tempo em que o grupo esteve de fato no PMU.
+    Uint64 enabled = now.time_enabled - mark->time_enabled;
+    Uint64 running = now.time_running - mark->time_running;
+    counters->time_enabled += enabled;
+    counters->time_running += running;
+    double scale = running > 0 ? (double)enabled / running : 0.0;
+
+    int state = counters->state >= 0 && counters->state < GAME_STATE_COUNT ? counters->state : 0;
+    CounterZone *totals = &counters->zones[zone];
+    totals->calls[state]++;
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        totals->values[state][c] += (Uint64)((now.values[c] - mark->values[c]) * scale + 0.5);
+    }
+}
+
+void counters_report(HardwareCounters *counters) {
+    if (!counters->enabled || counters->zone_count == 0) return;
+
+    FILE *file = fopen(COUNTERS_REPORT_PATH, "w");
+    if (!file) {
+        fprintf(stderr, "Error writing hardware counters '%s'\n", COUNTERS_REPORT_PATH);
+        return;
+    }
+
+    // os tempos de quadro por estado do HUD vão junto, para cada zona ser lida contra o quadro do seu estado:
+    double running = counters->time_enabled ? (double)counters->time_running / counters->time_enabled : 1.0;
+    fprintf(file, "{\"kernel\":%s,\"dropped\":%llu,\"running_fraction\":%.3f,\"states\":[", counters->kernel ? "true" : "false",
+            (unsigned long long)counters->dropped, running);
+    for (int state = 0; state < GAME_STATE_COUNT; state++) {
+        Uint64 replays = perf_hud.replay_frames[state];
+        const double *replay = perf_hud.replay_total[state];
+        double replay_divisor = replays ? (double)replays : 1.0;
+        fprintf(file, "%s\n{\"state\":\"%s\",\"ticks\":%llu,\"frames\":%llu,\"tick_ms\":{\"input\":%.3f,\"update\":%.3f},\"frame_ms\":{\"submit\":%.3f,\"present\":%.3f}",
+                state ? "," : "", game_state_names[state], (unsigned long long)perf_hud.state_ticks[state], (unsigned long long)perf_hud.state_frames[state],
+                perf_average_ms(&perf_hud, state, PERF_INPUT), perf_average_ms(&perf_hud, state, PERF_UPDATE), perf_average_ms(&perf_hud, state, PERF_SUBMIT), perf_average_ms(&perf_hud, state, PERF_PRESENT));
+        fprintf(file, ",\"replays\":%llu,\"replay_ms\":{\"input\":%.3f,\"submit\":%.3f,\"present\":%.3f},\"zones\":{", (unsigned long long)replays,
+                1000.0 * replay[PERF_INPUT] / replay_divisor, 1000.0 * replay[PERF_SUBMIT] / replay_divisor, 1000.0 * replay[PERF_PRESENT] / replay_divisor);
+
+        int written = 0;
+        for (int zone = 0; zone < counters->zone_count; zone++) {
+            const CounterZone *totals = &counters->zones[zone];
+            if (totals->calls[state] == 0) continue;
+
+            fprintf(file, "%s\n  ", written++ ? "," : "");
+            trace_write_string(file, totals->name);
+            fprintf(file, ":{\"calls\":%llu", (unsigned long long)totals->calls[state]);
+            for (int c = 0; c < COUNTER_COUNT; c++) {
+                if (counters->slot[c] >= 0) fprintf(file, ",\"%s\":%llu", counter_names[c], (unsigned long long)totals->values[state][c]);
+            }
+            fprintf(file, "}");
+        }
+        fprintf(file, "}}");
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("Hardware counters (%s, %.0f%% of the time on the PMU, per 1k instructions), written to %s:\n", counters->kernel ? "user+kernel" : "user only",
+           100.0 * running, COUNTERS_REPORT_PATH);
+    for (int state = 0; state < GAME_STATE_COUNT; state++) {
+        for (int zone = 0; zone < counters->zone_count; zone++) {
+            const CounterZone *totals = &counters->zones[zone];
+            if (totals->calls[state] == 0) continue;
+
+            const Uint64 *values = totals->values[state];
+            double kilo = values[COUNTER_INSTRUCTIONS] ? values[COUNTER_INSTRUCTIONS] / 1000.0 : 1.0;
+            printf("  %-13s %-17s %8llu calls  IPC %.2f  L1D %.2f  LLC %.2f  branch %.2f\n", game_state_names[state], totals->name,
+                   (unsigned long long)totals->calls[state], values[COUNTER_CYCLES] ? (double)values[COUNTER_INSTRUCTIONS] / values[COUNTER_CYCLES] : 0.0,
+                   values[COUNTER_L1D_MISSES] / kilo, values[COUNTER_LLC_MISSES] / kilo, values[COUNTER_BRANCH_MISSES] / kilo);
+        }
+    }
+}
+
+void counters_shutdown(HardwareCounters *counters) {
+    counters->enabled = false;
+#ifdef __linux__
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        if (counters->fds[c] >= 0) close(counters->fds[c]);
+        counters->fds[c] = -1;
+    }
+#endif
+}
+
+#ifdef SAMPLER_AVAILABLE
+static void sampler_signal(int signo, siginfo_t *info, void *context) {
+    (void)signo;
+    (void)info;
+    (void)context;
+    int saved_errno = errno;
+
+    // Só a thread principal recebe o sinal, e o consumidor é ela mesma fora do tratador: um escritor, um leitor.
+    int head = SDL_AtomicGet(&sampler.head);
+    if (head - SDL_AtomicGet(&sampler.tail) >= SAMPLER_RING_SIZE) {
+        SDL_AtomicIncRef(&sampler.dropped);
+        errno = saved_errno;
+        return;
+    }
+
+    Sample *sample = &sampler.ring[head & (SAMPLER_RING_SIZE - 1)];
+    void *frames[SAMPLER_DEPTH + SAMPLER_SKIP];
+    int depth = backtrace(frames, SAMPLER_DEPTH + SAMPLER_SKIP) - SAMPLER_SKIP;
+    sample->depth = SDL_max(depth, 0);
+    memcpy(sample->frames, frames + SAMPLER_SKIP, sizeof(void *) * sample->depth);
+    sample->game_state = sampler.flags->game_state;
+    sample->battle_state = sampler.flags->battle_state;
+    sample->battle_turn = sampler.flags->battle_turn;
+    SDL_AtomicSet(&sampler.head, head + 1);
+    errno = saved_errno;
+}
+#endif
+
+void sampler_init(Sampler *sampler, const GameState *flags) {
+    if (sampler->rate <= 0) return;
+
+#ifdef SAMPLER_AVAILABLE
+    sampler->flags = flags;
+    sampler->ring = calloc(SAMPLER_RING_SIZE, sizeof(Sample));
+    if (!sampler->ring) {
+        fprintf(stderr, "Error allocating the sampling profiler ring\n");
+        return;
+    }
+
+    // A primeira chamada de backtrace() carrega a libgcc; isso não pode acontecer dentro do tratador.
+    void *warmup[SAMPLER_SKIP];
+    backtrace(warmup, SAMPLER_SKIP);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = sampler_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, NULL) != 0) {
+        fprintf(stderr, "Error installing the SIGPROF handler: %s\n", strerror(errno));
+        return;
+    }
+
+    // O relógio é o tempo de CPU da thread principal: o tempo dormindo no vsync e no limitador não gera amostras.
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &sampler->timer) != 0) {
+        fprintf(stderr, "Error creating the sampling timer: %s\n", strerror(errno));
+        signal(SIGPROF, SIG_DFL);
+        return;
+    }
+
+    long period = 1000000000L / sampler->rate;
+    struct itimerspec interval = {{period / 1000000000L, period % 1000000000L}, {period / 1000000000L, period % 1000000000L}};
+    timer_settime(sampler->timer, 0, &interval, NULL);
+    sampler->enabled = true;
+#else
+    (void)flags;
+    fprintf(stderr, "The sampling profiler is only available on Linux with glibc\n");
+#endif
+}
+
+static Uint64 sampler_hash(const Sample *sample) {
+    // FNV-1a sobre as tags e os endereços da pilha
+    Uint64 hash = 14695981039346656037ULL;
+    int tags[3] = {sample->game_state, sample->battle_state, sample->battle_turn};
+    const unsigned char *bytes = (const unsigned char *)tags;
+    for (size_t i = 0; i < sizeof(tags); i++) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    bytes = (const unsigned char *)sample->frames;
+    for (size_t i = 0; i < sizeof(void *) * sample->depth; i++) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    return hash ? hash : 1;
+}
+
+static bool sampler_same(const Sample *a, const Sample *b) {
+    return a->depth == b->depth && a->game_state == b->game_state && a->battle_state == b->battle_state && a->battle_turn == b->battle_turn &&
+           memcmp(a->frames, b->frames, sizeof(void *) * a->depth) == 0;
+}
+
+static bool sampler_grow(Sampler *sampler) {
+    int capacity = sampler->capacity ? sampler->capacity * 2 : SAMPLER_STACKS_START;
+    SampleStack *stacks = calloc(capacity, sizeof(SampleStack));
+    if (!stacks) return false;
+
+    for (int i = 0; i < sampler->capacity; i++) {
+        if (!sampler->stacks[i].hash) continue;
+
+        int slot = sampler->stacks[i].hash & (capacity - 1);
+        while (stacks[slot].hash) slot = (slot + 1) & (capacity - 1);
+        stacks[slot] = sampler->stacks[i];
+    }
+    free(sampler->stacks);
+    sampler->stacks = stacks;
+    sampler->capacity = capacity;
+    return true;
+}
+
+void sampler_drain(Sampler *sampler) {
+    if (!sampler->ring) return;
+
+    int head = SDL_AtomicGet(&sampler->head);
+    for (int tail = SDL_AtomicGet(&sampler->tail); tail != head; tail++) {
+        const Sample *sample = &sampler->ring[tail & (SAMPLER_RING_SIZE - 1)];
+        sampler->samples++;
+
+        // cada pilha distinta (com as tags) é guardada uma vez, só com a contagem:
+        if (sampler->unique * 2 >= sampler->capacity && !sampler_grow(sampler)) {
+            SDL_AtomicIncRef(&sampler->dropped);
+            continue;
+        }
+        Uint64 hash = sampler_hash(sample);
+        int slot = hash & (sampler->capacity - 1);
+        while (sampler->stacks[slot].hash && (sampler->stacks[slot].hash != hash || !sampler_same(&sampler->stacks[slot].sample, sample))) {
+            slot = (slot + 1) & (sampler->capacity - 1);
+        }
+        if (!sampler->stacks[slot].hash) {
+            sampler->stacks[slot].hash = hash;
+            sampler->stacks[slot].sample = *sample;
+            sampler->unique++;
+        }
+        sampler->stacks[slot].count++;
+    }
+    SDL_AtomicSet(&sampler->tail, head);
+}
+
+static int folded_line_cmp(const void *a, const void *b) {
+    return strcmp(((const FoldedLine *)a)->text, ((const FoldedLine *)b)->text);
+}
+
+static void sampler_write_frame(FILE *file, const char *symbol) {
+    // "binário(função+0x1a) [0x...]" vira "função"; sem símbolo (compilado sem -rdynamic) fica "binário+0x..."
+    const char *open = strchr(symbol, '(');
+    const char *close = open ? strchr(open, ')') : NULL;
+    if (!open || !close) {
+        fprintf(file, ";%s", symbol);
+        return;
+    }
+
+    const char *name = open + 1;
+    const char *offset = memchr(name, '+', close - name);
+    if (offset && offset > name) {
+        fprintf(file, ";%.*s", (int)(offset - name), name);
+    }
+    else {
+        const char *binary = strrchr(symbol, '/');
+        binary = binary && binary < open ? binary + 1 : symbol;
+        fprintf(file, ";%.*s%.*s", (int)(open - binary), binary, (int)(close - name), name);
+    }
+}
+
+void sampler_shutdown(Sampler *sampler) {
+    if (!sampler->ring) return;
+
+#ifdef SAMPLER_AVAILABLE
+    if (sampler->enabled) {
+        timer_delete(sampler->timer);
+        signal(SIGPROF, SIG_IGN);
+        sampler->enabled = false;
+        sampler_drain(sampler);
+
+        FILE *file = fopen(SAMPLER_OUTPUT_PATH, "w");
+        if (!file) {
+            fprintf(stderr, "Error writing folded stacks '%s'\n", SAMPLER_OUTPUT_PATH);
+        }
+        else {
+            // Endereços diferentes da mesma função viram a mesma linha depois dos símbolos, então as linhas são ordenadas e somadas.
+            FoldedLine *lines = calloc(sampler->unique ? sampler->unique : 1, sizeof(FoldedLine));
+            int line_count = 0;
+            for (int i = 0; lines && i < sampler->capacity; i++) {
+                const SampleStack *stack = &sampler->stacks[i];
+                if (!stack->hash) continue;
+
+                size_t length = 0;
+                FILE *line = open_memstream(&lines[line_count].text, &length);
+                if (!line) continue;
+
+                // A raiz da pilha é o estado (e, na batalha, battle_state e turno), então o flamegraph já vem separado por estado.
+                const Sample *sample = &stack->sample;
+                bool known = sample->game_state >= 0 && sample->game_state < GAME_STATE_COUNT;
+                fprintf(line, "%s", known ? game_state_names[sample->game_state] : "unknown");
+                if (sample->game_state == BATTLE_SCREEN) fprintf(line, ";battle_state_%d;battle_turn_%d", sample->battle_state, sample->battle_turn);
+
+                char **symbols = backtrace_symbols(sample->frames, sample->depth);
+                for (int f = sample->depth - 1; f >= 0; f--) {
+                    if (symbols) sampler_write_frame(line, symbols[f]);
+                    else fprintf(line, ";%p", sample->frames[f]);
+                }
+                free(symbols);
+                fclose(line);
+                lines[line_count++].count = stack->count;
+            }
+
+            qsort(lines, line_count, sizeof(FoldedLine), folded_line_cmp);
+            for (int i = 0; i < line_count; i++) {
+                Uint64 count = lines[i].count;
+                while (i + 1 < line_count && strcmp(lines[i].text, lines[i + 1].text) == 0) {
+                    free(lines[i].text);
+                    count += lines[++i].count;
+                }
+                fprintf(file, "%s %llu\n", lines[i].text, (unsigned long long)count);
+                free(lines[i].text);
+            }
+            free(lines);
+            fclose(file);
+            printf("Sampler: %llu samples at %d Hz in %d distinct stacks (%d dropped) written to %s\n", (unsigned long long)sampler->samples, sampler->rate,
+                   sampler->unique, SDL_AtomicGet(&sampler->dropped), SAMPLER_OUTPUT_PATH);
+        }
+    }
+#endif
+
+    free(sampler->ring);
+    free(sampler->stacks);
+    sampler->ring = NULL;
+    sampler->stacks = NULL;
+}
+
+void flight_record(FlightRecorder *flight, const GameState *flags) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    if (flight->origin == 0) flight->origin = now;
+
+    FlightFrame *frame = &flight->frames[flight->next];
+    memset(frame, 0, sizeof(*frame));
+    frame->frame = flight->frame_index++;
+    frame->time = (now - flight->origin) / frequency;
+    frame->frame_ms = perf_hud.frame_start ? (float)((now - perf_hud.frame_start) * 1000.0 / frequency) : 0.0f;
+    for (int i = 0; i < PERF_PHASE_COUNT; i++) {
+        frame->phase_ms[i] = (float)(perf_hud.phase[i] * 1000.0);
+    }
+    frame->flags = *flags;
+
+    // ENTRADA NO FIM DO QUADRO:
+    const Uint8 *keys = SDL_GetKeyboardState(NULL);
+    for (int i = 0; i < FLIGHT_KEY_COUNT; i++) {
+        if (keys[flight_keys[i]]) frame->keys |= 1u << i;
+    }
+    frame->mouse_buttons = SDL_GetMouseState(&frame->mouse_x, &frame->mouse_y);
+    frame->channels_playing = Mix_Playing(-1);
+    frame->draw_calls = render_queue.frame.draw_calls;
+
+    // TEMPOS DAS ZONAS FECHADAS NA THREAD PRINCIPAL DESDE O ÚLTIMO QUADRO (INCLUSIVOS):
+    TraceRing *ring = tracer.enabled ? trace_ring() : NULL;
+    if (ring && ring->events) {
+        int head = SDL_AtomicGet(&ring->head);
+        int first = SDL_max(flight->seen_head, head - TRACE_RING_SIZE);
+        for (int i = first; i < head; i++) {
+            const TraceEvent *event = &ring->events[i & (TRACE_RING_SIZE - 1)];
+            int zone = 0;
+            while (zone < frame->zone_count && frame->zones[zone].name != event->name) zone++;
+            if (zone == frame->zone_count) {
+                if (zone >= FLIGHT_ZONES) continue;
+                frame->zones[frame->zone_count++].name = event->name;
+            }
+            frame->zones[zone].ms += (float)((event->end - event->start) * 1000.0 / frequency);
+            frame->zones[zone].count++;
+        }
+        flight->seen_head = head;
+    }
+
+    flight->next = (flight->next + 1) % FLIGHT_FRAMES;
+    if (flight->count < FLIGHT_FRAMES) flight->count++;
+
+    // Os primeiros quadros ainda carregam assets sob demanda, e um despejo puxa outro se não houver pausa.
+    if (flight->budget <= 0.0 || frame->frame_ms <= flight->budget * 1000.0) return;
+    if (frame->frame < FLIGHT_WARMUP_FRAMES || flight->dumps >= FLIGHT_MAX_DUMPS) return;
+    if (flight->dumps > 0 && frame->time - flight->last_dump < FLIGHT_COOLDOWN) return;
+
+    flight->last_dump = frame->time;
+    flight_dump(flight, frame);
+}
+
+static void flight_write_frame(FILE *file, const FlightFrame *frame) {
+    const GameState *flags = &frame->flags;
+    fprintf(file, "{\"frame\":%llu,\"time\":%.4f,\"frame_ms\":%.3f,\"draw_calls\":%d,\"channels_playing\":%d,\n",
+            (unsigned long long)frame->frame, frame->time, frame->frame_ms, frame->draw_calls, frame->channels_playing);
+    fprintf(file, " \"phases_ms\":{\"input\":%.3f,\"update\":%.3f,\"submit\":%.3f,\"present\":%.3f},\n \"zones_ms\":{",
+            frame->phase_ms[PERF_INPUT], frame->phase_ms[PERF_UPDATE], frame->phase_ms[PERF_SUBMIT], frame->phase_ms[PERF_PRESENT]);
+    for (int i = 0; i < frame->zone_count; i++) {
+        fprintf(file, "%s", i ? "," : "");
+        trace_write_string(file, frame->zones[i].name);
+        fprintf(file, ":{\"ms\":%.3f,\"count\":%d}", frame->zones[i].ms, frame->zones[i].count);
+    }
+    fprintf(file, "},\n \"input\":{\"keys\":[");
+    for (int i = 0, written = 0; i < FLIGHT_KEY_COUNT; i++) {
+        if (frame->keys & (1u << i)) fprintf(file, "%s\"%s\"", written++ ? "," : "", SDL_GetScancodeName(flight_keys[i]));
+    }
+    fprintf(file, "],\"mouse\":[%d,%d,%u]},\n", frame->mouse_x, frame->mouse_y, (unsigned)frame->mouse_buttons);
+    fprintf(file, " \"game_flags\":{\"game_state\":%d,\"player_state\":%d,\"battle_state\":%d,\"battle_turn\":%d,\"selected_button\":%d,\"menu_pos\":%d,"
+                  "\"food_amount\":%d,\"last_health\":%d,\"cutscene_index\":%d,\"death_count\":%d,\"on_dialogue\":%s,\"soul_ivulnerable\":%s,"
+                  "\"interaction_request\":%s,\"debug_mode\":%s,\"turn_timer\":%.3f,\"battle_timer\":%.3f}}",
+            flags->game_state, flags->player_state, flags->battle_state, flags->battle_turn, flags->selected_button, flags->menu_pos,
+            flags->food_amount, flags->last_health, flags->cutscene_index, flags->death_count, flags->on_dialogue ? "true" : "false",
+            flags->soul_ivulnerable ? "true" : "false", flags->interaction_request ? "true" : "false", flags->debug_mode ? "true" : "false",
+            flags->turn_timer, flags->battle_timer);
+}
+
+bool flight_dump(FlightRecorder *flight, const FlightFrame *trigger) {
+    // Um despejo por vez; o anterior ainda escrevendo faz este ser pulado.
+    if (SDL_AtomicGet(&flight->writing)) return true;
+    if (flight->writer) {
+        SDL_WaitThread(flight->writer, NULL);
+        flight->writer = NULL;
+    }
+
+    // A janela é copiada aqui e escrita numa thread, para o despejo não virar um segundo engasgo no laço.
+    FlightFrame *frames = malloc(sizeof(FlightFrame) * flight->count);
+    if (!frames) return true;
+    int count = 0;
+    for (int i = 0; i < flight->count; i++) {
+        const FlightFrame *frame = &flight->frames[(flight->next - flight->count + i + FLIGHT_FRAMES) % FLIGHT_FRAMES];
+        if (frame->time >= trigger->time - FLIGHT_SECONDS) frames[count++] = *frame;
+    }
+
+    flight->pending = frames;
+    flight->pending_count = count;
+    flight->pending_trigger = *trigger;
+    flight->pending_dump = ++flight->dumps;
+    SDL_AtomicSet(&flight->writing, 1);
+    flight->writer = SDL_CreateThread(flight_writer, "flight-writer", flight);
+    if (!flight->writer) {
+        fprintf(stderr, "Error creating flight writer thread: %s\n", SDL_GetError());
+        flight_writer(flight);
+    }
+    return false;
+}
+
+static int flight_writer(void *data) {
+    FlightRecorder *flight = data;
+    const FlightFrame *trigger = &flight->pending_trigger;
+    char path[PATH_LENGTH];
+    snprintf(path, sizeof(path), FLIGHT_DUMP_FORMAT, flight->pending_dump);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Error writing flight recording '%s'\n", path);
+    }
+    else {
+        double window = flight->pending_count ? trigger->time - flight->pending[0].time : 0.0;
+        fprintf(file, "{\"budget_ms\":%.3f,\"trigger_frame\":%llu,\"trigger_ms\":%.3f,\"window_s\":%.3f,\"frames\":[\n", flight->budget * 1000.0,
+                (unsigned long long)trigger->frame, trigger->frame_ms, window);
+        for (int i = 0; i < flight->pending_count; i++) {
+            fprintf(file, "%s", i ? ",\n" : "");
+            flight_write_frame(file, &flight->pending[i]);
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        printf("Flight recorder: %.1f ms frame over the %.1f ms budget, %d frames (%.2fs) written to %s\n", trigger->frame_ms, flight->budget * 1000.0,
+               flight->pending_count, window, path);
+
+        // o trace completo dos anéis cobre a mesma janela com as zonas aninhadas:
+        if (tracer.enabled) {
+            snprintf(path, sizeof(path), FLIGHT_TRACE_FORMAT, flight->pending_dump);
+            trace_dump(path);
+        }
+    }
+
+    free(flight->pending);
+    flight->pending = NULL;
+    SDL_AtomicSet(&flight->writing, 0);
+    return 0;
+}
+
+void flight_shutdown(FlightRecorder *flight) {
+    if (!flight->writer) return;
+
+    SDL_WaitThread(flight->writer, NULL);
+    flight->writer = NULL;
+}
+
+void headless_prepare(Headless *headless) {
+    if (!headless->enabled) return;
+
+    // Os drivers precisam ser escolhidos antes do SDL_Init; o renderizador por software desenha
+    // numa superfície em memória, então todo o caminho de desenho continua sendo executado.
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+    // Sem tela não há vsync; sem --fps o jogo roda o mais rápido possível.
+    frame_pacer.vsync_requested = false;
+    if (frame_pacer.target_rate < 0) frame_pacer.target_rate = 0;
+}
+
+bool headless_frame(Headless *headless) {
+    // --frames também vale com janela: a contagem e o relatório servem para testes de resistência nos dois modos.
+    if (!headless->enabled && headless->frame_limit <= 0) return false;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (headless->frames == 0) headless->started = now;
+    else {
+        double frame = (double)(now - headless->last) / SDL_GetPerformanceFrequency();
+        if (frame > headless->worst) headless->worst = frame;
+    }
+    headless->last = now;
+    headless->frames++;
+
+    return headless->frame_limit > 0 && headless->frames >= (Uint64)headless->frame_limit;
+}
+
+void headless_report(Headless *headless) {
+    if ((!headless->enabled && headless->frame_limit <= 0) || headless->frames < 2) return;
+
+    double total = (double)(headless->last - headless->started) / SDL_GetPerformanceFrequency();
+    printf("%s: %llu frames in %.2fs (%.3f ms average, %.3f ms worst) on %s/%s.\n", headless->enabled ? "Headless" : "Windowed",
+           (unsigned long long)headless->frames, total, 1000.0 * total / (headless->frames - 1), 1000.0 * headless->worst, SDL_GetCurrentVideoDriver() ? SDL_GetCurrentVideoDriver() : "none",
+           SDL_GetCurrentAudioDriver() ? SDL_GetCurrentAudioDriver() : "none");
+}
+
+void frame_pacer_init(FramePacer *pacer, SDL_Renderer *render, SDL_Window *window) {
+    pacer->frequency = SDL_GetPerformanceFrequency();
+    pacer->spin = PACER_SPIN_START;
+
+    SDL_RendererInfo info;
+    pacer->vsync = SDL_GetRendererInfo(render, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC);
+
+    SDL_DisplayMode mode;
+    int display = SDL_GetWindowDisplayIndex(window);
+    pacer->refresh_rate = display >= 0 && SDL_GetCurrentDisplayMode(display, &mode) == 0 && mode.refresh_rate > 0 ? mode.refresh_rate : 60;
+
+    // Sem vsync e sem --fps, o limite é a taxa da tela; --fps 0 com --no-vsync deixa sem limite.
+    int rate = pacer->target_rate;
+    if (rate < 0) rate = pacer->vsync ? 0 : pacer->refresh_rate;
+    pacer->period = rate > 0 ? pacer->frequency / rate : 0;
+}
+
+double frame_pacer_frame(FramePacer *pacer) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (pacer->last_frame == 0) pacer->last_frame = now;
+
+    double raw = (double)(now - pacer->last_frame) / pacer->frequency;
+    pacer->last_frame = now;
+    pacer->frames++;
+
+    // Com vsync os quadros caem em múltiplos do período da tela, então o ruído do relógio é descartado.
+    if (pacer->vsync && pacer->refresh_rate > 0) {
+        double refresh = 1.0 / pacer->refresh_rate;
+        double multiple = floor(raw / refresh + 0.5);
+        if (multiple >= 1.0 && fabs(raw - multiple * refresh) < PACER_SNAP_TOLERANCE) raw = multiple * refresh;
+    }
+
+    pacer->history[pacer->history_next] = raw;
+    pacer->history_next = (pacer->history_next + 1) % PACER_HISTORY;
+    if (pacer->history_count < PACER_HISTORY) pacer->history_count++;
+
+    double average = 0.0;
+    for (int i = 0; i < pacer->history_count; i++) {
+        average += pacer->history[i];
+    }
+    average /= pacer->history_count;
+
+    // o que a média adianta ou atrasa fica guardado e é devolvido quando passa de um quadro,
+    // então o tempo total da simulação continua igual ao do relógio:
+    pacer->residual += raw - average;
+    double smoothed = average;
+    if (fabs(pacer->residual) > average) {
+        smoothed += pacer->residual;
+        pacer->residual = 0.0;
+    }
+    pacer->smoothed = smoothed;
+    return smoothed;
+}
+
+void frame_pacer_wait(FramePacer *pacer) {
+    if (pacer->period == 0) return; // o vsync (ou nada, no modo sem limite) dita o ritmo.
+
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    // Atrasado mais de um quadro: o prazo recomeça agora, sem rajada para recuperar.
+    if (pacer->deadline == 0 || now > pacer->deadline + pacer->period) pacer->deadline = now;
+    if (now >= pacer->deadline) {
+        pacer->deadline += pacer->period;
+        return;
+    }
+
+    // DORME ATÉ PERTO DO PRAZO E TERMINA EM ESPERA ATIVA, COM A MARGEM AJUSTADA AO ATRASO DO SDL_Delay:
+    double remaining = (double)(pacer->deadline - now) / pacer->frequency;
+    if (remaining > pacer->spin) {
+        double requested = remaining - pacer->spin;
+        SDL_Delay((Uint32)(requested * 1000.0));
+        Uint64 woke = SDL_GetPerformanceCounter();
+        double slept = (double)(woke - now) / pacer->frequency;
+        double overshoot = slept - (Uint32)(requested * 1000.0) / 1000.0;
+
+        if (overshoot > pacer->spin) pacer->spin = SDL_min(overshoot, PACER_SPIN_MAX);
+        else pacer->spin = SDL_max(pacer->spin * 0.99, PACER_SPIN_MIN);
+        pacer->slept += slept;
+        now = woke;
+    }
+
+    Uint64 spin_start = now;
+    while (now < pacer->deadline) {
+        now = SDL_GetPerformanceCounter();
+    }
+    pacer->spun += (double)(now - spin_start) / pacer->frequency;
+    pacer->deadline += pacer->period;
+}
+
+void frame_pacer_idle(FramePacer *pacer, double seconds) {
+    // arredonda para cima: acordar um pouco depois garante que o tick já venceu na próxima volta.
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_Delay((Uint32)ceil(SDL_max(seconds, 0.0) * 1000.0));
+    pacer->slept += (double)(SDL_GetPerformanceCounter() - start) / pacer->frequency;
+}
+
+void render_queue_free(void) {
+    free(render_queue.commands);
+    free(render_queue.vertices);
+    free(render_queue.indices);
+    render_queue.commands = NULL;
+    render_queue.vertices = NULL;
+    render_queue.indices = NULL;
+    render_queue.count = render_queue.capacity = render_queue.flushed = 0;
+    render_queue.vertex_count = render_queue.vertex_capacity = render_queue.index_quads = 0;
+}
+
+int render_queue_overlay(SDL_Renderer *render, GlyphAtlas *atlas, int x, int y) {
+    if (!atlas) return y;
+
+    char line[128];
+    snprintf(line, sizeof(line), "Queue: %d cmds  %d draws  %d state  %d elided", render_queue.last.commands, render_queue.last.draw_calls, render_queue.last.state_changes, render_queue.last.elided);
+    text_batch_begin(&text_batch, atlas);
+    text_batch_string(&text_batch, line, x, y);
+    text_batch_flush(render, &text_batch);
+    return y + (atlas->font ? TTF_FontLineSkip(atlas->font) : 16);
+}
+
+HudText hud_text_create(GlyphAtlas *atlas, const char *format, int value) {
+    HudText hud = {.atlas = atlas, .format = format, .value = value, .dirty = true};
+
+    // a strip de dígitos entra no atlas aqui, então atualizações posteriores não chamam o TTF:
+    for (const char *c = HUD_DIGITS; *c != '\0'; c++) {
+        char utf8_buffer[2] = {*c, '\0'};
+        glyph_atlas_glyph(atlas, utf8_buffer);
+    }
+    hud_text_compose(&hud);
+    return hud;
+}
+
+void hud_text_set(HudText *hud, int value) {
+    if (hud->value == value) return;
+
+    hud->value = value;
+    hud->dirty = true;
+}
+
+static void hud_text_compose(HudText *hud) {
+    char buffer[HUD_TEXT_LENGTH + 1];
+    snprintf(buffer, sizeof(buffer), hud->format, hud->value);
+
+    hud->glyph_count = 0;
+    hud->collision.w = 0;
+    hud->collision.h = hud->atlas && hud->atlas->font ? TTF_FontHeight(hud->atlas->font) : 0;
+    for (int byte = 0; buffer[byte] != '\0' && hud->glyph_count < HUD_TEXT_LENGTH;) {
+        char utf8_buffer[5];
+        byte += utf8_copy_char(&buffer[byte], utf8_buffer);
+        int glyph = glyph_atlas_glyph(hud->atlas, utf8_buffer);
+        if (glyph < 0) continue;
+
+        hud->glyphs[hud->glyph_count++] = glyph;
+        hud->collision.w += hud->atlas->glyphs[glyph].rect.w;
+    }
+    hud->dirty = false;
+}
+
+void hud_text_render(SDL_Renderer *render, HudText *hud) {
+    if (!hud->atlas) return;
+    if (hud->dirty) hud_text_compose(hud);
+
+    int x = hud->collision.x;
+    text_batch_begin(&text_batch, hud->atlas);
+    for (int i = 0; i < hud->glyph_count; i++) {
+        const Glyph *glyph = &hud->atlas->glyphs[hud->glyphs[i]];
+        text_batch_add(&text_batch, glyph, x, hud->collision.y);
+        x += glyph->rect.w;
+    }
+    text_batch_flush(render, &text_batch);
+}
+
+Sprite *create_sprite(SDL_Renderer *render, const char *dir) {
+    const AtlasEntry *entry = atlas_find(dir);
+    if (entry && !atlas_pages[entry->page]) {
+        Uint32 states = atlas_page_states(entry->page);
+        if (residency_deferred(states)) {
+            Sprite *sprite = residency_defer_sprite(atlas_page_paths[entry->page], dir, states, entry->rect);
+            if (!sprite) sprite_failures++;
+            return sprite;
+        }
+    }
+    else if (!entry && residency_deferred(residency_states(dir))) {
+        Sprite *sprite = residency_defer_sprite(dir, dir, residency_states(dir), (SDL_Rect){0, 0, 0, 0});
+        if (!sprite) sprite_failures++;
+        return sprite;
+    }
+
+    if (entry) {
+        // Páginas são enviadas na primeira vez em que um sprite delas é pedido.
+        if (!atlas_pages[entry->page]) {
+            atlas_pages[entry->page] = create_texture(render, atlas_page_paths[entry->page]);
+        }
+
+        Sprite *sprite = sprite_from_texture(atlas_pages[entry->page]);
+        if (sprite) {
+            sprite->src = entry->rect;
+            sprite->w = entry->rect.w;
+            sprite->h = entry->rect.h;
+        }
+        else {
+            fprintf(stderr, "Error loading sprite '%s' from atlas page '%s'\n", dir, atlas_page_paths[entry->page]);
+            sprite_failures++;
+        }
+        residency_track_sprite(sprite, atlas_page_paths[entry->page], dir);
+        return sprite;
+    }
+
+    Sprite *sprite = sprite_from_texture(create_texture(render, dir));
+    if (!sprite) {
+        // As animações guardam o ponteiro sem checar; a falha é contada e o main aborta antes do primeiro quadro.
+        fprintf(stderr, "Error loading sprite '%s'\n", dir);
+        sprite_failures++;
+    }
+    residency_track_sprite(sprite, dir, dir);
+    return sprite;
+}
+
+Sprite *sprite_from_texture(SDL_Texture *texture) {
+    if (!texture) return NULL;
+
+    Sprite *sprite = malloc(sizeof(Sprite));
+    if (!sprite) {
+        fprintf(stderr, "Error allocating sprite\n");
+        return NULL;
+    }
+
+    sprite->alpha = 255;
+    sprite->resident = 0;
+    sprite_assign_texture(sprite, texture);
+    track_sprite(sprite);
+    return sprite;
+}
+
+void sprite_assign_texture(Sprite *sprite, SDL_Texture *texture) {
+    if (!sprite) return;
+
+    int w = 0, h = 0;
+    if (texture) SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+
+    sprite->texture = texture;
+    sprite->src = (SDL_Rect){0, 0, w, h};
+    sprite->w = w;
+    sprite->h = h;
+}
+
+void sprite_set_alpha(Sprite *sprite, Uint8 alpha) {
+    if (sprite) sprite->alpha = alpha;
+}
+
+static bool sprite_ready(SDL_Renderer *render, Sprite *sprite) {
+    if (!sprite) return false;
+    if (sprite->texture) return true;
+
+    return residency_fault(render, sprite);
+}
+
+static bool cull_outside(const SDL_FRect *dst) {
+    return dst->w <= 0 || dst->h <= 0 || dst->x + dst->w <= 0 || dst->y + dst->h <= 0 || dst->x >= SCREEN_WIDTH || dst->y >= SCREEN_HEIGHT;
+}
+
+static int cull_rect(const SDL_Rect *src, const SDL_FRect *dst, SDL_Rect *clipped_src, SDL_FRect *clipped_dst) {
+    float left = dst->x, top = dst->y, right = dst->x + dst->w, bottom = dst->y + dst->h;
+    if (cull_outside(dst)) return CULL_OUTSIDE;
+    if (left >= 0 && top >= 0 && right <= SCREEN_WIDTH && bottom <= SCREEN_HEIGHT) return CULL_VISIBLE;
+
+    // A região de origem é arredondada para fora em texels inteiros e o destino é recalculado
+    // a partir dela, para que a escala (e a amostragem) continue idêntica à do desenho inteiro.
+    float scale_x = src->w / dst->w, scale_y = src->h / dst->h;
+    int x0 = src->x + (int)floorf((SDL_max(left, 0.0f) - left) * scale_x);
+    int y0 = src->y + (int)floorf((SDL_max(top, 0.0f) - top) * scale_y);
+    int x1 = src->x + (int)ceilf((SDL_min(right, (float)SCREEN_WIDTH) - left) * scale_x);
+    int y1 = src->y + (int)ceilf((SDL_min(bottom, (float)SCREEN_HEIGHT) - top) * scale_y);
+    if (x1 > src->x + src->w) x1 = src->x + src->w;
+    if (y1 > src->y + src->h) y1 = src->y + src->h;
+
+    *clipped_src = (SDL_Rect){x0, y0, x1 - x0, y1 - y0};
+    *clipped_dst = (SDL_FRect){left + (x0 - src->x) / scale_x, top + (y0 - src->y) / scale_y, clipped_src->w / scale_x, clipped_src->h / scale_y};
+    return CULL_CLIPPED;
+}
+
+static void render_culled(SDL_Renderer *render, Sprite *sprite, const SDL_FRect *dst, const SDL_FRect *from) {
+    SDL_Rect src;
+    SDL_FRect clipped;
+
+    // Interpolado, o retângulo final só é conhecido no envio, então o sprite vai inteiro.
+    if (from) {
+        if (cull_outside(dst) && cull_outside(from)) {
+            cull_stats.frame.culled++;
+            return;
+        }
+        if (!sprite_ready(render, sprite)) return;
+        cull_stats.frame.drawn++;
+        render_queue_copy(render, sprite->texture, &sprite->src, dst, from, 0.0, SDL_FLIP_NONE, sprite->alpha);
+        return;
+    }
+
+    switch (cull_rect(&sprite->src, dst, &src, &clipped)) {
+    case CULL_OUTSIDE:
+        cull_stats.frame.culled++;
+        return;
+    case CULL_CLIPPED:
+        if (!sprite_ready(render, sprite)) return;
+        cull_stats.frame.clipped++;
+        render_queue_copy(render, sprite->texture, &src, &clipped, NULL, 0.0, SDL_FLIP_NONE, sprite->alpha);
+        return;
+    default:
+        if (!sprite_ready(render, sprite)) return;
+        cull_stats.frame.drawn++;
+        render_queue_copy(render, sprite->texture, &sprite->src, dst, NULL, 0.0, SDL_FLIP_NONE, sprite->alpha);
+        return;
+    }
+}
+
+void render_sprite(SDL_Renderer *render, Sprite *sprite, const SDL_Rect *dst) {
+    if (!sprite) return;
+    if (dst) {
+        SDL_FRect fdst = {dst->x, dst->y, dst->w, dst->h}, from;
+        bool lerp = render_queue_track(dst, &fdst, &from);
+        if (render_queue.discard) return;
+        render_culled(render, sprite, &fdst, lerp ? &from : NULL);
+        return;
+    }
+    if (render_queue.discard || !sprite_ready(render, sprite)) return;
+
+    // Páginas de atlas são compartilhadas, então o alpha vai junto com cada comando.
+    cull_stats.frame.drawn++;
+    render_queue_copy(render, sprite->texture, &sprite->src, NULL, NULL, 0.0, SDL_FLIP_NONE, sprite->alpha);
+}
+
+void render_sprite_ex(SDL_Renderer *render, Sprite *sprite, const SDL_Rect *dst, double angle, SDL_RendererFlip flip) {
+    SDL_FRect fdst = dst ? (SDL_FRect){dst->x, dst->y, dst->w, dst->h} : (SDL_FRect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT}, from;
+    bool lerp = render_queue_track(dst, &fdst, &from);
+    if (render_queue.discard) return;
+
+    // Com rotação o retângulo não limita o desenho, então só o caso sem ângulo é descartado.
+    if (dst && angle == 0.0 && cull_outside(&fdst) && (!lerp || cull_outside(&from))) {
+        cull_stats.frame.culled++;
+        return;
+    }
+    if (!sprite_ready(render, sprite)) return;
+
+    cull_stats.frame.drawn++;
+    render_queue_copy(render, sprite->texture, &sprite->src, &fdst, lerp ? &from : NULL, angle, flip, sprite->alpha);
+}
+
+void render_sprite_f(SDL_Renderer *render, Sprite *sprite, const SDL_FRect *dst) {
+    if (!sprite) return;
+    if (dst) {
+        SDL_FRect from;
+        bool lerp = render_queue_track(dst, dst, &from);
+        if (render_queue.discard) return;
+        render_culled(render, sprite, dst, lerp ? &from : NULL);
+        return;
+    }
+    if (render_queue.discard || !sprite_ready(render, sprite)) return;
+
+    cull_stats.frame.drawn++;
+    render_queue_copy(render, sprite->texture, &sprite->src, dst, NULL, 0.0, SDL_FLIP_NONE, sprite->alpha);
+}
+
+void render_sprite_exf(SDL_Renderer *render, Sprite *sprite, const SDL_FRect *dst, double angle, SDL_RendererFlip flip) {
+    SDL_FRect from;
+    bool lerp = dst && render_queue_track(dst, dst, &from);
+    if (render_queue.discard) return;
+
+    if (dst && angle == 0.0 && cull_outside(dst) && (!lerp || cull_outside(&from))) {
+        cull_stats.frame.culled++;
+        return;
+    }
+    if (!sprite_ready(render, sprite)) return;
+
+    cull_stats.frame.drawn++;
+    render_queue_copy(render, sprite->texture, &sprite->src, dst, lerp ? &from : NULL, angle, flip, sprite->alpha);
+}
+
+bool atlas_load(const char *index_path) {
+    char *text = asset_read_text(index_path);
+    if (!text) return false; // Sem atlas: os sprites vêm de arquivos soltos.
+
+    char path[PATH_LENGTH];
+    int entry_capacity = 0;
+    bool failed = false;
+
+    char *next = NULL;
+    for (char *line = text; line && *line && !failed; line = next) {
+        next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        int page, x, y, w, h;
+
+        if (sscanf(line, "page %d %511[^\r\n]", &page, path) == 2) {
+            if (page != atlas_page_count) {
+                fprintf(stderr, "Error loading atlas '%s': unexpected page %d\n", index_path, page);
+                failed = true;
+                continue;
+            }
+
+            SDL_Texture **pages = realloc(atlas_pages, (atlas_page_count + 1) * sizeof(*atlas_pages));
+            failed = !pages;
+            if (failed) continue;
+            atlas_pages = pages;
+
+            char **page_paths = realloc(atlas_page_paths, (atlas_page_count + 1) * sizeof(*atlas_page_paths));
+            failed = !page_paths;
+            if (failed) continue;
+            atlas_page_paths = page_paths;
+
+            atlas_pages[atlas_page_count] = NULL;
+            atlas_page_paths[atlas_page_count] = strdup(path);
+            atlas_page_count++;
+        }
+        else if (sscanf(line, "sprite %d %d %d %d %d %511[^\r\n]", &page, &x, &y, &w, &h, path) == 6) {
+            if (page < 0 || page >= atlas_page_count) continue;
+
+            if (atlas_entry_count >= entry_capacity) {
+                entry_capacity = entry_capacity ? entry_capacity * 2 : 128;
+                AtlasEntry *entries = realloc(atlas_entries, entry_capacity * sizeof(*atlas_entries));
+                failed = !entries;
+                if (failed) continue;
+                atlas_entries = entries;
+            }
+
+            atlas_entries[atlas_entry_count++] = (AtlasEntry){strdup(path), page, {x, y, w, h}};
+        }
+    }
+    free(text);
+
+    // Atlas pela metade é descartado inteiro: os sprites voltam para os arquivos soltos.
+    if (failed) {
+        atlas_unload();
+        return true;
+    }
+
+    atlas_slot_capacity = 64;
+    while (atlas_slot_capacity < atlas_entry_count * 2) atlas_slot_capacity *= 2;
+    atlas_slots = calloc(atlas_slot_capacity, sizeof(*atlas_slots));
+    if (!atlas_slots) {
+        atlas_unload();
+        return true;
+    }
+
+    for (int i = 0; i < atlas_entry_count; i++) {
+        Uint32 slot = hash_string(atlas_entries[i].path) & (atlas_slot_capacity - 1);
+        while (atlas_slots[slot]) slot = (slot + 1) & (atlas_slot_capacity - 1);
+        atlas_slots[slot] = i + 1;
+    }
+
+    return false;
+}
+
+static const AtlasEntry *atlas_find(const char *path) {
+    if (!atlas_slots) return NULL;
+
+    Uint32 slot = hash_string(path) & (atlas_slot_capacity - 1);
+    while (atlas_slots[slot]) {
+        const AtlasEntry *entry = &atlas_entries[atlas_slots[slot] - 1];
+        if (strcmp(entry->path, path) == 0) return entry;
+        slot = (slot + 1) & (atlas_slot_capacity - 1);
+    }
+
+    return NULL;
+}
+
+void atlas_unload(void) {
+    // As texturas das páginas são liberadas pelo rastreador de texturas.
+    for (int i = 0; i < atlas_entry_count; i++) {
+        free(atlas_entries[i].path);
+    }
+    for (int i = 0; i < atlas_page_count; i++) {
+        free(atlas_page_paths[i]);
+    }
+    free(atlas_entries);
+    free(atlas_pages);
+    free(atlas_page_paths);
+    free(atlas_slots);
+
+    atlas_entries = NULL;
+    atlas_pages = NULL;
+    atlas_page_paths = NULL;
+    atlas_slots = NULL;
+    atlas_entry_count = atlas_page_count = atlas_slot_capacity = 0;
+}
+
+bool build_atlas(const char *sprites_dir, const char *out_dir) {
+    if (SDL_Init(0) || (IMG_Init(IMAGE_FLAGS) & IMAGE_FLAGS) != IMAGE_FLAGS) {
+        fprintf(stderr, "Error initializing SDL_image: %s\n", IMG_GetError());
+        return true;
+    }
+
+    char **paths = NULL;
+    int path_count = 0, path_capacity = 0;
+    collect_files(sprites_dir, ".png", &paths, &path_count, &path_capacity);
+
+    AtlasSource *sources = calloc(path_count ? path_count : 1, sizeof(AtlasSource));
+    int source_count = 0, loose_count = 0;
+    size_t root_len = strlen(sprites_dir);
+    bool failed = (sources == NULL);
+
+    for (int i = 0; i < path_count && !failed; i++) {
+        SDL_Surface *loaded = IMG_Load(paths[i]);
+        if (!loaded) {
+            fprintf(stderr, "Error loading image '%s': %s\n", paths[i], IMG_GetError());
+            continue;
+        }
+
+        // Cenários e frames de história em tela cheia continuam como arquivos soltos.
+        if (loaded->w > ATLAS_MAX_SPRITE || loaded->h > ATLAS_MAX_SPRITE) {
+            SDL_FreeSurface(loaded);
+            loose_count++;
+            continue;
+        }
+
+        // A entrada só entra no vetor depois da conversão, para o qsort e o empacotamento nunca verem superfície nula.
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+        if (!converted) {
+            fprintf(stderr, "Error converting image '%s': %s\n", paths[i], SDL_GetError());
+            failed = true;
+            break;
+        }
+
+        AtlasSource *source = &sources[source_count++];
+        source->path = paths[i];
+        source->surface = converted;
+
+        // O balde é o diretório relativo do sprite: "assets/sprites/battle/if.png" -> "battle".
+        const char *relative = paths[i] + root_len + 1;
+        const char *slash = strrchr(relative, '/');
+        int bucket_len = slash ? (int)(slash - relative) : 0;
+        if (bucket_len >= (int)sizeof(source->bucket)) bucket_len = sizeof(source->bucket) - 1;
+        if (bucket_len == 0) {
+            strcpy(source->bucket, "root");
+        }
+        else {
+            memcpy(source->bucket, relative, bucket_len);
+            source->bucket[bucket_len] = '\0';
+            for (char *c = source->bucket; *c; c++) {
+                if (*c == '/') *c = '-';
+            }
+        }
+    }
+
+    qsort(sources, source_count, sizeof(AtlasSource), atlas_source_cmp);
+
+    // EMPACOTAMENTO EM PRATELEIRAS (uma sequência de páginas por diretório):
+    int page_count = 0;
+    int x = 0, y = 0, shelf_h = 0;
+    for (int i = 0; i < source_count && !failed; i++) {
+        AtlasSource *source = &sources[i];
+        int w = source->surface->w;
+        int h = source->surface->h;
+
+        bool new_page = (i == 0 || strcmp(source->bucket, sources[i - 1].bucket) != 0);
+        if (!new_page && x + w + ATLAS_PADDING > ATLAS_PAGE_SIZE) {
+            x = ATLAS_PADDING;
+            y += shelf_h + ATLAS_PADDING;
+            shelf_h = 0;
+        }
+        if (!new_page && y + h + ATLAS_PADDING > ATLAS_PAGE_SIZE) new_page = true;
+
+        if (new_page) {
+            page_count++;
+            x = y = ATLAS_PADDING;
+            shelf_h = 0;
+        }
+
+        source->page = page_count - 1;
+        source->rect = (SDL_Rect){x, y, w, h};
+        x += w + ATLAS_PADDING;
+        if (h > shelf_h) shelf_h = h;
+    }
+
+    if (!failed && make_directory(out_dir)) {
+        fprintf(stderr, "Error creating directory '%s'\n", out_dir);
+        failed = true;
+    }
+
+    char index_path[PATH_LENGTH];
+    snprintf(index_path, sizeof(index_path), "%s/atlas.txt", out_dir);
+    FILE *index = failed ? NULL : fopen(index_path, "w");
+    if (!failed && !index) {
+        fprintf(stderr, "Error writing atlas index '%s'\n", index_path);
+        failed = true;
+    }
+
+    int first = 0;
+    for (int page = 0; page < page_count && !failed; page++) {
+        int last = first;
+        int page_w = 0, page_h = 0;
+        while (last < source_count && sources[last].page == page) {
+            SDL_Rect r = sources[last].rect;
+            if (r.x + r.w + ATLAS_PADDING > page_w) page_w = r.x + r.w + ATLAS_PADDING;
+            if (r.y + r.h + ATLAS_PADDING > page_h) page_h = r.y + r.h + ATLAS_PADDING;
+            last++;
+        }
+
+        SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, page_w, page_h, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!surface) {
+            fprintf(stderr, "Error creating atlas page: %s\n", SDL_GetError());
+            failed = true;
+            break;
+        }
+
+        for (int i = first; i < last; i++) {
+            SDL_SetSurfaceBlendMode(sources[i].surface, SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(sources[i].surface, NULL, surface, &sources[i].rect);
+        }
+
+        char page_path[PATH_LENGTH];
+        snprintf(page_path, sizeof(page_path), "%s/atlas-%s-%d.png", out_dir, sources[first].bucket, page);
+        if (IMG_SavePNG(surface, page_path)) {
+            fprintf(stderr, "Error saving atlas page '%s': %s\n", page_path, IMG_GetError());
+            failed = true;
+        }
+        SDL_FreeSurface(surface);
+
+        fprintf(index, "page %d %s\n", page, page_path);
+        for (int i = first; i < last; i++) {
+            SDL_Rect r = sources[i].rect;
+            fprintf(index, "sprite %d %d %d %d %d %s\n", page, r.x, r.y, r.w, r.h, sources[i].path);
+        }
+        first = last;
+    }
+
+    if (index) fclose(index);
+    if (!failed) {
+        printf("Atlas: %d sprites in %d pages, %d large images left as loose files.\n", source_count, page_count, loose_count);
+    }
+
+    for (int i = 0; i < source_count; i++) {
+        SDL_FreeSurface(sources[i].surface);
+    }
+    for (int i = 0; i < path_count; i++) {
+        free(paths[i]);
+    }
+    free(sources);
+    free(paths);
+
+    IMG_Quit();
+    SDL_Quit();
+    return failed;
+}
+
+bool pack_open(const char *path) {
+#ifdef _WIN32
+    // Sem mmap: o pacote é lido inteiro para a memória uma única vez.
+    FILE *file = fopen(path, "rb");
+    if (!file) return false; // Sem pacote: os assets vêm de arquivos soltos.
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    Uint8 *data = size > 0 ? malloc(size) : NULL;
+    if (!data || fread(data, 1, size, file) != (size_t)size) {
+        fprintf(stderr, "Error reading asset pack '%s'\n", path);
+        free(data);
+        fclose(file);
+        return true;
+    }
+    fclose(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false; // Sem pacote: os assets vêm de arquivos soltos.
+
+    struct stat info;
+    if (fstat(fd, &info) || info.st_size <= 0) {
+        fprintf(stderr, "Error reading asset pack '%s'\n", path);
+        close(fd);
+        return true;
+    }
+
+    size_t size = (size_t)info.st_size;
+    Uint8 *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Error mapping asset pack '%s'\n", path);
+        return true;
+    }
+#endif
+
+    pack_data = data;
+    pack_size = (size_t)size;
+
+    const PackHeader *header = (const PackHeader *)pack_data;
+    if (pack_size < sizeof(PackHeader) || memcmp(header->magic, PACK_MAGIC, 4) != 0 || header->version != PACK_VERSION ||
+        header->index_offset % PACK_ALIGNMENT != 0 ||
+        header->index_offset + (size_t)header->entry_count * sizeof(PackEntry) > pack_size) {
+        fprintf(stderr, "Error loading asset pack '%s': invalid header\n", path);
+        pack_close();
+        return true;
+    }
+
+    pack_entries = (const PackEntry *)(pack_data + header->index_offset);
+    pack_entry_count = header->entry_count;
+
+    // Cada entrada é validada aqui para pack_find e asset_open_rw poderem confiar no índice; um pacote
+    // truncado ou corrompido é rejeitado inteiro e os assets voltam a vir de arquivos soltos.
+    for (int i = 0; i < pack_entry_count; i++) {
+        const PackEntry *entry = &pack_entries[i];
+        bool compressed = (entry->flags & PACK_FLAG_LZ4) != 0;
+        if (!memchr(entry->path, '\0', PACK_PATH_LENGTH) || entry->size > SDL_MAX_SINT32 || entry->stored_size > SDL_MAX_SINT32 ||
+            (size_t)entry->offset + entry->stored_size > pack_size || (!compressed && entry->stored_size != entry->size)) {
+            fprintf(stderr, "Error loading asset pack '%s': invalid entry %d\n", path, i);
+            pack_close();
+            return true;
+        }
+    }
+
+    pack_slot_capacity = 64;
+    while (pack_slot_capacity < pack_entry_count * 2) pack_slot_capacity *= 2;
+    pack_slots = calloc(pack_slot_capacity, sizeof(*pack_slots));
+    if (!pack_slots) {
+        pack_close();
+        return true;
+    }
+
+    for (int i = 0; i < pack_entry_count; i++) {
+        Uint32 slot = hash_string(pack_entries[i].path) & (pack_slot_capacity - 1);
+        while (pack_slots[slot]) slot = (slot + 1) & (pack_slot_capacity - 1);
+        pack_slots[slot] = i + 1;
+    }
+
+    return false;
+}
+
+static const PackEntry *pack_find(const char *path) {
+    if (!pack_slots) return NULL;
+
+    Uint32 slot = hash_string(path) & (pack_slot_capacity - 1);
+    while (pack_slots[slot]) {
+        const PackEntry *entry = &pack_entries[pack_slots[slot] - 1];
+        if (strcmp(entry->path, path) == 0) return entry;
+        slot = (slot + 1) & (pack_slot_capacity - 1);
+    }
+
+    return NULL;
+}
+
+static int pack_close_owned(SDL_RWops *rw) {
+    if (rw) {
+        free(rw->hidden.mem.base);
+        SDL_FreeRW(rw);
+    }
+
+    return 0;
+}
+
+SDL_RWops *asset_open_rw(const char *path) {
+    const PackEntry *entry = pack_find(path);
+    if (!entry) return SDL_RWFromFile(path, "rb");
+
+    if (!(entry->flags & PACK_FLAG_LZ4)) {
+        return SDL_RWFromConstMem(pack_data + entry->offset, (int)entry->size);
+    }
+
+#ifdef CTALE_USE_LZ4
+    // Entradas comprimidas são expandidas num buffer próprio, liberado junto com o RWops.
+    char *buffer = malloc(entry->size ? entry->size : 1);
+    if (!buffer) return NULL;
+
+    int result = LZ4_decompress_safe((const char *)pack_data + entry->offset, buffer, (int)entry->stored_size, (int)entry->size);
+    if (result != (int)entry->size) {
+        SDL_SetError("Corrupted LZ4 entry '%s' in asset pack", path);
+        free(buffer);
+        return NULL;
+    }
+
+    SDL_RWops *rw = SDL_RWFromConstMem(buffer, (int)entry->size);
+    if (!rw) {
+        free(buffer);
+        return NULL;
+    }
+    rw->close = pack_close_owned;
+    return rw;
+#else
+    (void) pack_close_owned;
+    SDL_SetError("Asset '%s' is LZ4-compressed but LZ4 support was not compiled in", path);
+    return NULL;
+#endif
+}
+
+static char *asset_read_text(const char *path) {
+    SDL_RWops *rw = asset_open_rw(path);
+    if (!rw) return NULL;
+
+    Sint64 size = SDL_RWsize(rw);
+    char *text = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    if (!text || SDL_RWread(rw, text, 1, (size_t)size) != (size_t)size) {
+        free(text);
+        SDL_RWclose(rw);
+        return NULL;
+    }
+    text[size] = '\0';
+
+    SDL_RWclose(rw);
+    return text;
+}
+
+static size_t asset_size(const char *path) {
+    const PackEntry *entry = pack_find(path);
+    if (entry) return entry->size;
+
+    struct stat info;
+    return stat(path, &info) == 0 ? (size_t)info.st_size : 0;
+}
+
+static void asset_list(const char *dir, const char *ext, char ***paths, int *count, int *capacity) {
+    if (!pack_slots) {
+        collect_files(dir, ext, paths, count, capacity);
+        return;
+    }
+
+    size_t dir_len = strlen(dir);
+    size_t ext_len = strlen(ext);
+    for (int i = 0; i < pack_entry_count; i++) {
+        const char *path = pack_entries[i].path;
+        size_t len = strlen(path);
+        if (len <= dir_len || strncmp(path, dir, dir_len) != 0 || path[dir_len] != '/') continue;
+        if (len < ext_len || strcmp(path + len - ext_len, ext) != 0) continue;
+
+        if (*count >= *capacity) {
+            *capacity = *capacity ? *capacity * 2 : 128;
+            *paths = realloc(*paths, *capacity * sizeof(**paths));
+        }
+        (*paths)[(*count)++] = strdup(path);
+    }
+}
+
+void pack_close(void) {
+    if (pack_data) {
+#ifdef _WIN32
+        free(pack_data);
+#else
+        munmap(pack_data, pack_size);
+#endif
+    }
+    free(pack_slots);
+
+    pack_data = NULL;
+    pack_size = 0;
+    pack_entries = NULL;
+    pack_slots = NULL;
+    pack_entry_count = pack_slot_capacity = 0;
+}
+
+bool build_pack(const char *assets_dir, const char *out_path) {
+    char **paths = NULL;
+    int path_count = 0, path_capacity = 0;
+    collect_files(assets_dir, "", &paths, &path_count, &path_capacity);
+
+    // Sprites que já estão no atlas não precisam ir para o pacote; sem atlas válido, todos vão.
+    (void)atlas_load(ATLAS_INDEX_PATH);
+
+    FILE *file = fopen(out_path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error writing asset pack '%s'\n", out_path);
+        atlas_unload();
+        for (int i = 0; i < path_count; i++) {
+            free(paths[i]);
+        }
+        free(paths);
+        return true;
+    }
+
+    PackHeader header = {PACK_MAGIC, PACK_VERSION, 0, 0};
+    PackEntry *entries = calloc(path_count ? path_count : 1, sizeof(PackEntry));
+    Uint32 offset = sizeof(PackHeader);
+    size_t raw_bytes = 0, stored_bytes = 0;
+    int compressed_count = 0;
+    bool failed = (entries == NULL);
+    fwrite(&header, sizeof(header), 1, file);
+
+    for (int i = 0; i < path_count && !failed; i++) {
+        if (atlas_find(paths[i])) continue;
+        if (strlen(paths[i]) >= PACK_PATH_LENGTH) {
+            fprintf(stderr, "Skipping '%s': path too long for asset pack\n", paths[i]);
+            continue;
+        }
+
+        FILE *source = fopen(paths[i], "rb");
+        if (!source) {
+            fprintf(stderr, "Error reading '%s'\n", paths[i]);
+            failed = true;
+            break;
+        }
+        fseek(source, 0, SEEK_END);
+        long size = ftell(source);
+        fseek(source, 0, SEEK_SET);
+        char *data = malloc(size > 0 ? size : 1);
+        if (!data || fread(data, 1, size, source) != (size_t)size) {
+            fprintf(stderr, "Error reading '%s'\n", paths[i]);
+            free(data);
+            fclose(source);
+            failed = true;
+            break;
+        }
+        fclose(source);
+
+        PackEntry *entry = &entries[header.entry_count++];
+        strcpy(entry->path, paths[i]);
+        entry->size = (Uint32)size;
+        entry->stored_size = (Uint32)size;
+
+        const char *stored = data;
+#ifdef CTALE_USE_LZ4
+        // Só vale comprimir quando economiza de verdade (PNG e OGG já vêm comprimidos).
+        int bound = LZ4_compressBound((int)size);
+        char *packed = malloc(bound > 0 ? bound : 1);
+        int packed_size = packed ? LZ4_compress_default(data, packed, (int)size, bound) : 0;
+        if (packed_size > 0 && packed_size < size - size / 8) {
+            entry->flags |= PACK_FLAG_LZ4;
+            entry->stored_size = (Uint32)packed_size;
+            stored = packed;
+            compressed_count++;
+        }
+#endif
+
+        static const char zeros[PACK_ALIGNMENT] = {0};
+        Uint32 aligned = (offset + PACK_ALIGNMENT - 1) & ~(Uint32)(PACK_ALIGNMENT - 1);
+        fwrite(zeros, 1, aligned - offset, file);
+        entry->offset = aligned;
+        fwrite(stored, 1, entry->stored_size, file);
+        offset = aligned + entry->stored_size;
+
+        raw_bytes += entry->size;
+        stored_bytes += entry->stored_size;
+#ifdef CTALE_USE_LZ4
+        free(packed);
+#endif
+        free(data);
+    }
+
+    if (!failed) {
+        static const char zeros[PACK_ALIGNMENT] = {0};
+        header.index_offset = (offset + PACK_ALIGNMENT - 1) & ~(Uint32)(PACK_ALIGNMENT - 1);
+        fwrite(zeros, 1, header.index_offset - offset, file);
+        fwrite(entries, sizeof(PackEntry), header.entry_count, file);
+
+        fseek(file, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, file);
+        failed = ferror(file) != 0;
+    }
+    fclose(file);
+
+    if (failed) {
+        fprintf(stderr, "Error building asset pack '%s'\n", out_path);
+        remove(out_path);
+    }
+    else {
+        printf("Pack: %u files, %zu bytes stored (%zu raw, %d compressed).\n",
+               header.entry_count, stored_bytes, raw_bytes, compressed_count);
+    }
+
+    atlas_unload();
+    for (int i = 0; i < path_count; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+    free(entries);
+    return failed;
+}
+
+static void *cache_find(AssetCache *cache, const char *key) {
+    if (!cache->key_slots) return NULL;
+
+    Uint32 slot = hash_string(key) & (cache->slot_capacity - 1);
+    while (cache->key_slots[slot]) {
+        CacheEntry *entry = &cache->entries[cache->key_slots[slot] - 1];
+        if (strcmp(entry->key, key) == 0) {
+            cache->hits++;
+            return entry->handle;
+        }
+        slot = (slot + 1) & (cache->slot_capacity - 1);
+    }
+
+    return NULL;
+}
+
+static void *cache_find_content(AssetCache *cache, Uint64 content_hash, SDL_Surface *surface) {
+    if (!cache->content_slots || !content_hash) return NULL;
+
+    Uint32 slot = (Uint32)content_hash & (cache->slot_capacity - 1);
+    while (cache->content_slots[slot]) {
+        CacheEntry *entry = &cache->entries[cache->content_slots[slot] - 1];
+        // O hash só seleciona o candidato; a textura só é compartilhada se os pixels forem realmente iguais.
+        if (entry->content_hash == content_hash && surface_same_content(surface, entry->key)) {
+            cache->content_hits++;
+            return entry->handle;
+        }
+        slot = (slot + 1) & (cache->slot_capacity - 1);
+    }
+
+    return NULL;
+}
+
+static void cache_index(AssetCache *cache, int index) {
+    CacheEntry *entry = &cache->entries[index];
+
+    Uint32 slot = hash_string(entry->key) & (cache->slot_capacity - 1);
+    while (cache->key_slots[slot]) slot = (slot + 1) & (cache->slot_capacity - 1);
+    cache->key_slots[slot] = index + 1;
+
+    if (entry->content_hash) {
+        slot = (Uint32)entry->content_hash & (cache->slot_capacity - 1);
+        while (cache->content_slots[slot]) slot = (slot + 1) & (cache->slot_capacity - 1);
+        cache->content_slots[slot] = index + 1;
+    }
+}
+
+static void cache_insert(AssetCache *cache, const char *key, Uint64 content_hash, void *handle) {
+    if (cache->count >= cache->capacity) {
+        int capacity = cache->capacity ? cache->capacity * 2 : 64;
+        CacheEntry *entries = realloc(cache->entries, capacity * sizeof(*entries));
+        if (!entries) return;
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+
+    // Fator de carga de no máximo 1/2: ao crescer, as duas tabelas são reconstruídas.
+    if ((cache->count + 1) * 2 > cache->slot_capacity) {
+        int slot_capacity = cache->slot_capacity ? cache->slot_capacity * 2 : 128;
+        int *key_slots = calloc(slot_capacity, sizeof(*key_slots));
+        int *content_slots = calloc(slot_capacity, sizeof(*content_slots));
+        if (!key_slots || !content_slots) {
+            free(key_slots);
+            free(content_slots);
+            return;
+        }
+
+        free(cache->key_slots);
+        free(cache->content_slots);
+        cache->key_slots = key_slots;
+        cache->content_slots = content_slots;
+        cache->slot_capacity = slot_capacity;
+        for (int i = 0; i < cache->count; i++) {
+            cache_index(cache, i);
+        }
+    }
+
+    cache->entries[cache->count] = (CacheEntry){strdup(key), content_hash, handle};
+    cache_index(cache, cache->count++);
+}
+
+static int cache_remove_handle(AssetCache *cache, void *handle) {
+    // Remoções só acontecem em trocas de estado; as tabelas são reconstruídas sem o handle.
+    // Cada entrada removida devolve a referência que segurava.
+    int kept = 0;
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].handle == handle) {
+            free(cache->entries[i].key);
+            resource_release(handle);
+            continue;
+        }
+        cache->entries[kept++] = cache->entries[i];
+    }
+    int removed = cache->count - kept;
+    if (removed == 0) return 0;
+
+    cache->count = kept;
+    memset(cache->key_slots, 0, cache->slot_capacity * sizeof(*cache->key_slots));
+    memset(cache->content_slots, 0, cache->slot_capacity * sizeof(*cache->content_slots));
+    for (int i = 0; i < cache->count; i++) {
+        cache_index(cache, i);
+    }
+    return removed;
+}
+
+static void cache_clear(AssetCache *cache) {
+    // Cada entrada segura uma referência no registro; o handle só é destruído quando a última sai.
+    for (int i = 0; i < cache->count; i++) {
+        free(cache->entries[i].key);
+        resource_release(cache->entries[i].handle);
+    }
+    free(cache->entries);
+    free(cache->key_slots);
+    free(cache->content_slots);
+    memset(cache, 0, sizeof(*cache));
+}
+
+static Uint64 hash_surface(SDL_Surface *surface) {
+    Uint64 hash = 14695981039346656037ull;
+    int header[3] = {surface->w, surface->h, (int)surface->format->format};
+    hash = hash_bytes(hash, header, sizeof(header));
+
+    if (surface->format->palette) {
+        SDL_Palette *palette = surface->format->palette;
+        hash = hash_bytes(hash, palette->colors, palette->ncolors * sizeof(SDL_Color));
+    }
+
+    // Só os bytes visíveis de cada linha; o preenchimento do pitch é ignorado.
+    size_t row_bytes = (size_t)surface->w * surface->format->BytesPerPixel;
+    const Uint8 *row = surface->pixels;
+    for (int y = 0; y < surface->h; y++, row += surface->pitch) {
+        hash = hash_words(hash, row, row_bytes);
+    }
+
+    return hash ? hash : 1;
+}
+
+static bool surface_same_content(SDL_Surface *a, const char *path) {
+    // Acontece só quando os hashes batem, então decodificar o outro arquivo de novo custa pouco no total.
+    SDL_Surface *decoded = loader_surface(path, NULL);
+    SDL_Surface *b = decoded ? decoded : IMG_Load_RW(asset_open_rw(path), 1);
+    if (!b) return false;
+
+    bool same = a->w == b->w && a->h == b->h && a->pitch == b->pitch && a->format->format == b->format->format;
+    SDL_Palette *pa = a->format->palette, *pb = b->format->palette;
+    if (same && (pa || pb)) {
+        same = pa && pb && pa->ncolors == pb->ncolors && memcmp(pa->colors, pb->colors, pa->ncolors * sizeof(SDL_Color)) == 0;
+    }
+
+    size_t row_bytes = (size_t)a->w * a->format->BytesPerPixel;
+    const Uint8 *row_a = a->pixels, *row_b = b->pixels;
+    for (int y = 0; same && y < a->h; y++, row_a += a->pitch, row_b += b->pitch) {
+        same = memcmp(row_a, row_b, row_bytes) == 0;
+    }
+
+    if (!decoded) SDL_FreeSurface(b);
+    return same;
+}
+
+void profile_start(bool enabled, const char *benchmark) {
+    profiler.start = SDL_GetPerformanceCounter();
+    profiler.benchmark = benchmark;
+    profiler.enabled = enabled || benchmark;
+    if (!profiler.enabled) return;
+
+    profiler.mutex = SDL_CreateMutex();
+    if (!profiler.mutex) {
+        fprintf(stderr, "Error creating profiler mutex: %s\n", SDL_GetError());
+        profiler.enabled = false;
+        return;
+    }
+
+    if (benchmark && strcmp(benchmark, "cold") == 0) {
+        profile_drop_file_cache();
+    }
+}
+
+static void profile_record(const char *name, const char *category, Uint64 start, size_t bytes) {
+    if (!profiler.enabled) return;
+
+    ProfileEvent event = {strdup(name), category, start, SDL_GetPerformanceCounter(), SDL_ThreadID(), bytes};
+
+    SDL_LockMutex(profiler.mutex);
+    if (profiler.count >= profiler.capacity) {
+        profiler.capacity = profiler.capacity ? profiler.capacity * 2 : 256;
+        profiler.events = realloc(profiler.events, profiler.capacity * sizeof(*profiler.events));
+    }
+    profiler.events[profiler.count++] = event;
+    SDL_UnlockMutex(profiler.mutex);
+}
+
+static void profile_drop_file_cache(void) {
+#if defined(POSIX_FADV_DONTNEED)
+    // Partida a frio sem root: pede ao kernel que descarte as páginas em cache dos assets.
+    char **paths = NULL;
+    int path_count = 0, path_capacity = 0;
+    collect_files(ASSETS_DIR, "", &paths, &path_count, &path_capacity);
+
+    int dropped = 0;
+    for (int i = -1; i < path_count; i++) {
+        int fd = open(i < 0 ? PACK_PATH : paths[i], O_RDONLY);
+        if (fd < 0) continue;
+        if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0) dropped++;
+        close(fd);
+    }
+
+    for (int i = 0; i < path_count; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+    printf("Startup benchmark: dropped page cache for %d files.\n", dropped);
+#else
+    printf("Startup benchmark: page cache cannot be dropped on this platform, cold run is warm.\n");
+#endif
+}
+
+static void trace_write_string(FILE *file, const char *s) {
+    fputc('"', file);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(file, "\\%c", c);
+        }
+        else if (c < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        }
+        else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+void profile_finish(void) {
+    if (!profiler.enabled) return;
+
+    profile_record("startup", "startup", profiler.start, 0);
+    profiler.enabled = false;
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    FILE *trace = fopen(STARTUP_TRACE_PATH, "w");
+    if (!trace) {
+        fprintf(stderr, "Error writing startup trace '%s'\n", STARTUP_TRACE_PATH);
+    }
+    else {
+        fprintf(trace, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        for (int i = 0; i < profiler.count; i++) {
+            ProfileEvent *event = &profiler.events[i];
+            fprintf(trace, "%s{\"name\":", i ? ",\n" : "");
+            trace_write_string(trace, event->name);
+            fprintf(trace, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"bytes\":%zu}}",
+                    event->category, (event->start - profiler.start) * 1e6 / frequency,
+                    (event->end - event->start) * 1e6 / frequency, (unsigned long)event->thread, event->bytes);
+        }
+        fprintf(trace, "\n]}\n");
+        fclose(trace);
+    }
+
+    // RESUMO: totais por categoria e os N eventos mais lentos.
+    const char *categories[] = {"init", "load", "decode", "upload", "wait"};
+    double totals[5] = {0};
+    size_t decoded_bytes = 0, uploaded_bytes = 0;
+    double wall_ms = 0.0;
+    for (int i = 0; i < profiler.count; i++) {
+        ProfileEvent *event = &profiler.events[i];
+        double ms = (event->end - event->start) * 1000.0 / frequency;
+        for (int n = 0; n < 5; n++) {
+            if (strcmp(event->category, categories[n]) == 0) totals[n] += ms;
+        }
+        if (strcmp(event->category, "decode") == 0) decoded_bytes += event->bytes;
+        if (strcmp(event->category, "upload") == 0) uploaded_bytes += event->bytes;
+        if (strcmp(event->category, "startup") == 0) wall_ms = ms;
+    }
+
+    printf("Startup profile: %.1f ms wall, %d events, trace written to %s\n", wall_ms, profiler.count, STARTUP_TRACE_PATH);
+    for (int n = 0; n < 5; n++) {
+        printf("  %-7s %9.1f ms\n", categories[n], totals[n]);
+    }
+    printf("  decoded %.1f MB, uploaded %.1f MB\n", decoded_bytes / (1024.0 * 1024.0), uploaded_bytes / (1024.0 * 1024.0));
+
+    qsort(profiler.events, profiler.count, sizeof(ProfileEvent), profile_event_cmp);
+    printf("  slowest:\n");
+    for (int i = 0, shown = 0; i < profiler.count && shown < STARTUP_TOP_N; i++) {
+        ProfileEvent *event = &profiler.events[i];
+        if (strcmp(event->category, "startup") == 0) continue;
+        printf("  %9.2f ms  %-6s %8.1f KB  thread %lu  %s\n", (event->end - event->start) * 1000.0 / frequency,
+               event->category, event->bytes / 1024.0, (unsigned long)event->thread, event->name);
+        shown++;
+    }
+
+    if (profiler.benchmark) {
+        FILE *bench = fopen(STARTUP_BENCH_PATH, "a+");
+        if (!bench) {
+            fprintf(stderr, "Error writing startup benchmark '%s'\n", STARTUP_BENCH_PATH);
+        }
+        else {
+            fseek(bench, 0, SEEK_END);
+            if (ftell(bench) == 0) {
+                fprintf(bench, "unix_time,mode,wall_ms,init_ms,load_ms,decode_ms,upload_ms,wait_ms,decoded_bytes,uploaded_bytes\n");
+            }
+            fprintf(bench, "%ld,%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%zu,%zu\n", (long)time(NULL), profiler.benchmark, wall_ms,
+                    totals[0], totals[1], totals[2], totals[3], totals[4], decoded_bytes, uploaded_bytes);
+            fclose(bench);
+        }
+    }
+
+    for (int i = 0; i < profiler.count; i++) {
+        free(profiler.events[i].name);
+    }
+    free(profiler.events);
+    SDL_DestroyMutex(profiler.mutex);
+    profiler.events = NULL;
+    profiler.count = profiler.capacity = 0;
+    profiler.mutex = NULL;
+}
+
+static Uint32 residency_states(const char *path) {
+    for (size_t i = 0; i < sizeof(residency_rules) / sizeof(residency_rules[0]); i++) {
+        if (strncmp(path, residency_rules[i].prefix, strlen(residency_rules[i].prefix)) == 0) {
+            return residency_rules[i].states;
+        }
+    }
+
+    return ALL_STATES;
+}
+
+static bool png_size(const char *path, int *w, int *h) {
+    SDL_RWops *rw = asset_open_rw(path);
+    if (!rw) return false;
+
+    // Assinatura de 8 bytes, depois o chunk IHDR com largura e altura em big-endian.
+    Uint8 header[24];
+    bool valid = SDL_RWread(rw, header, 1, sizeof(header)) == sizeof(header) && memcmp(header + 1, "PNG", 3) == 0 &&
+                 memcmp(header + 12, "IHDR", 4) == 0;
+    SDL_RWclose(rw);
+    if (!valid) return false;
+
+    *w = (int)((Uint32)header[16] << 24 | (Uint32)header[17] << 16 | (Uint32)header[18] << 8 | header[19]);
+    *h = (int)((Uint32)header[20] << 24 | (Uint32)header[21] << 16 | (Uint32)header[22] << 8 | header[23]);
+    return true;
+}
+
+static Uint32 atlas_page_states(int page) {
+    Uint32 states = 0;
+    for (int i = 0; i < atlas_entry_count; i++) {
+        if (atlas_entries[i].page == page) states |= residency_states(atlas_entries[i].path);
+    }
+
+    return states;
+}
+
+static bool residency_deferred(Uint32 states) {
+    return !(states & STATE_BIT(residency.startup_state));
+}
+
+static Sprite *residency_defer_sprite(const char *source_path, const char *dir, Uint32 states, SDL_Rect src) {
+    int w, h;
+    if (!png_size(source_path, &w, &h)) {
+        fprintf(stderr, "Error reading image size '%s'\n", source_path);
+        return NULL;
+    }
+    if (src.w == 0 && src.h == 0) src = (SDL_Rect){0, 0, w, h};
+
+    int index = 0;
+    while (index < residency.texture_count && strcmp(residency.textures[index].path, source_path) != 0) index++;
+    if (index == residency.texture_count) {
+        if (!residency_reserve_texture()) return NULL;
+        residency.textures[index] = (ResidentTexture){strdup(source_path), NULL, NULL, 0, (size_t)w * h * 4};
+        residency.texture_count++;
+    }
+    residency.textures[index].states |= states;
+
+    // A textura só é enviada na entrada do estado (ou antes, pelo prefetch); até lá o sprite só conhece o tamanho.
+    Sprite *sprite = malloc(sizeof(Sprite));
+    if (!sprite) {
+        fprintf(stderr, "Error allocating sprite '%s'\n", dir);
+        return NULL;
+    }
+    sprite->texture = NULL;
+    sprite->src = src;
+    sprite->w = src.w;
+    sprite->h = src.h;
+    sprite->alpha = 255;
+    sprite->resident = index + 1;
+    track_sprite(sprite);
+    return sprite;
+}
+
+static bool residency_reserve_texture(void) {
+    if (residency.texture_count < residency.texture_capacity) return true;
+
+    int capacity = residency.texture_capacity ? residency.texture_capacity * 2 : 64;
+    ResidentTexture *textures = realloc(residency.textures, capacity * sizeof(*residency.textures));
+    if (!textures) {
+        fprintf(stderr, "Error allocating residency table\n");
+        return false;
+    }
+    residency.textures = textures;
+    residency.texture_capacity = capacity;
+    return true;
+}
+
+static bool residency_reserve_sound(void) {
+    if (residency.sound_count < residency.sound_capacity) return true;
+
+    int capacity = residency.sound_capacity ? residency.sound_capacity * 2 : 32;
+    ResidentSound *sounds = realloc(residency.sounds, capacity * sizeof(*residency.sounds));
+    if (!sounds) {
+        fprintf(stderr, "Error allocating residency table\n");
+        return false;
+    }
+    residency.sounds = sounds;
+    residency.sound_capacity = capacity;
+    return true;
+}
+
+static Mix_Chunk *residency_defer_chunk(const char *dir, int volume, Uint32 states) {
+    // O marcador só identifica o Sound em residency_track_sounds; depois disso o Sound fica nulo até o estado carregar.
+    Mix_Chunk *placeholder = calloc(1, sizeof(Mix_Chunk));
+    if (!placeholder || !residency_reserve_sound()) {
+        free(placeholder);
+        fprintf(stderr, "Error deferring chunk %s\n", dir);
+        return NULL;
+    }
+
+    residency.sounds[residency.sound_count++] = (ResidentSound){strdup(dir), NULL, NULL, NULL, volume, states, placeholder};
+    return placeholder;
+}
+
+static void residency_track_sprite(Sprite *sprite, const char *source_path, const char *dir) {
+    if (!sprite || !sprite->texture) return;
+
+    // Uma entrada por textura: páginas de atlas e texturas deduplicadas somam os estados de todos os sprites.
+    Uint32 states = residency_states(dir);
+    for (int i = 0; i < residency.texture_count; i++) {
+        if (residency.textures[i].texture == sprite->texture) {
+            residency.textures[i].states |= states;
+            sprite->resident = i + 1;
+            return;
+        }
+    }
+
+    if (!residency_reserve_texture()) return;
+
+    int w = 0, h = 0;
+    SDL_QueryTexture(sprite->texture, NULL, NULL, &w, &h);
+
+    residency.textures[residency.texture_count] = (ResidentTexture){strdup(source_path), sprite->texture, NULL, states, (size_t)w * h * 4};
+    residency.resident_bytes += (size_t)w * h * 4;
+    sprite->resident = ++residency.texture_count;
+}
+
+static void residency_track_chunk(Mix_Chunk *chunk, const char *dir, int volume) {
+    Uint32 states = residency_states(dir);
+    if (!chunk || states == ALL_STATES) return;
+
+    if (!residency_reserve_sound()) return;
+
+    residency.sounds[residency.sound_count++] = (ResidentSound){strdup(dir), NULL, chunk, NULL, volume, states, NULL};
+}
+
+void residency_track_sounds(Sound *sounds, int count) {
+    for (int i = 0; i < count; i++) {
+        for (int n = 0; n < residency.sound_count; n++) {
+            ResidentSound *entry = &residency.sounds[n];
+            if (!sounds[i].sound) continue;
+
+            if (entry->chunk == sounds[i].sound) {
+                entry->sound = &sounds[i];
+            }
+            else if (entry->placeholder == sounds[i].sound) {
+                entry->sound = &sounds[i];
+                sounds[i].sound = NULL;
+            }
+        }
+    }
+}
+
+static void residency_install_texture(int index, SDL_Texture *texture) {
+    ResidentTexture *entry = &residency.textures[index];
+    entry->texture = texture;
+    if (texture) {
+        resource_register(texture, RESOURCE_TEXTURE);
+        resource_name(texture, entry->path);
+        residency.resident_bytes += entry->bytes;
+    }
+
+    for (int i = 0; i < guarded_sprites_count; i++) {
+        if (guarded_sprites[i]->resident == index + 1) {
+            guarded_sprites[i]->texture = texture;
+        }
+    }
+    for (int i = 0; i < atlas_page_count; i++) {
+        if (strcmp(atlas_page_paths[i], entry->path) == 0) {
+            atlas_pages[i] = texture;
+        }
+    }
+}
+
+static void residency_install_sound(int index, Mix_Chunk *chunk) {
+    ResidentSound *entry = &residency.sounds[index];
+    entry->chunk = chunk;
+    if (chunk) {
+        Mix_VolumeChunk(chunk, entry->volume);
+        resource_register(chunk, RESOURCE_CHUNK);
+        resource_name(chunk, entry->path);
+    }
+    if (entry->sound) entry->sound->sound = chunk;
+}
+
+static void residency_upload(SDL_Renderer *render, int index, SDL_Surface *surface) {
+    ResidentTexture *entry = &residency.textures[index];
+    if (!surface) surface = IMG_Load_RW(asset_open_rw(entry->path), 1);
+    if (!surface) {
+        fprintf(stderr, "Error loading image '%s': %s\n", entry->path, IMG_GetError());
+        return;
+    }
+
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(render, surface);
+    SDL_FreeSurface(surface);
+    if (!texture) {
+        fprintf(stderr, "Error creating texture: %s", SDL_GetError());
+        return;
+    }
+
+    residency_install_texture(index, texture);
+}
+
+static int residency_load(SDL_Renderer *render, int state) {
+    Uint32 bit = STATE_BIT(state);
+    int loaded = 0;
+
+    for (int i = 0; i < residency.texture_count; i++) {
+        ResidentTexture *entry = &residency.textures[i];
+        if (entry->texture || !(entry->states & bit)) continue;
+
+        SDL_Surface *pending = entry->pending;
+        entry->pending = NULL;
+        residency_upload(render, i, pending);
+        loaded++;
+    }
+
+    for (int i = 0; i < residency.sound_count; i++) {
+        ResidentSound *entry = &residency.sounds[i];
+        if (entry->chunk || !(entry->states & bit)) continue;
+
+        Mix_Chunk *chunk = entry->pending ? entry->pending : Mix_LoadWAV_RW(asset_open_rw(entry->path), 1);
+        entry->pending = NULL;
+        if (!chunk) {
+            fprintf(stderr, "Error loading chunk %s: %s", entry->path, Mix_GetError());
+            continue;
+        }
+        residency_install_sound(i, chunk);
+        loaded++;
+    }
+
+    return loaded;
+}
+
+static int residency_evict(int state) {
+    Uint32 bit = STATE_BIT(state);
+    int evicted = 0;
+
+    for (int i = 0; i < residency.texture_count; i++) {
+        ResidentTexture *entry = &residency.textures[i];
+        if (entry->states & bit) continue;
+
+        if (entry->pending) {
+            SDL_FreeSurface(entry->pending);
+            entry->pending = NULL;
+        }
+        if (!entry->texture) continue;
+
+        SDL_Texture *texture = entry->texture;
+        residency_install_texture(i, NULL);
+        // Texturas vindas de create_texture são das entradas do cache; as enviadas pela residência são dela.
+        if (cache_remove_handle(&texture_cache, texture) == 0) resource_release(texture);
+        residency.resident_bytes -= entry->bytes;
+        evicted++;
+    }
+
+    for (int i = 0; i < residency.sound_count; i++) {
+        ResidentSound *entry = &residency.sounds[i];
+        if (entry->states & bit) continue;
+
+        if (entry->pending) {
+            Mix_FreeChunk(entry->pending);
+            entry->pending = NULL;
+        }
+        if (!entry->chunk) continue;
+
+        // Mix_FreeChunk interrompe os canais que ainda tocam o chunk.
+        Mix_Chunk *chunk = entry->chunk;
+        residency_install_sound(i, NULL);
+        resource_release(chunk);
+        evicted++;
+    }
+
+    return evicted;
+}
+
+void residency_prefetch(int state) {
+    if (residency.prefetch_thread || state == residency.state || residency.prefetch_state == state) return;
+
+    Uint32 bit = STATE_BIT(state);
+    bool missing = false;
+    for (int i = 0; i < residency.texture_count && !missing; i++) {
+        missing = !residency.textures[i].texture && (residency.textures[i].states & bit);
+    }
+    for (int i = 0; i < residency.sound_count && !missing; i++) {
+        missing = !residency.sounds[i].chunk && (residency.sounds[i].states & bit);
+    }
+    if (!missing) return;
+
+    residency.prefetch_state = state;
+    SDL_AtomicSet(&residency.prefetch_done, 0);
+    residency.prefetch_thread = SDL_CreateThread(residency_prefetch_worker, "asset-prefetch", NULL);
+    if (!residency.prefetch_thread) {
+        fprintf(stderr, "Error creating prefetch thread: %s\n", SDL_GetError());
+    }
+}
+
+static int residency_prefetch_worker(void *data) {
+    (void) data;
+    Uint32 bit = STATE_BIT(residency.prefetch_state);
+
+    // Só decodifica; o envio para a GPU e a troca dos handles ficam com a thread principal.
+    for (int i = 0; i < residency.texture_count; i++) {
+        ResidentTexture *entry = &residency.textures[i];
+        if (!entry->texture && !entry->pending && (entry->states & bit)) {
+            entry->pending = IMG_Load_RW(asset_open_rw(entry->path), 1);
+        }
+    }
+    for (int i = 0; i < residency.sound_count; i++) {
+        ResidentSound *entry = &residency.sounds[i];
+        if (!entry->chunk && !entry->pending && (entry->states & bit)) {
+            entry->pending = Mix_LoadWAV_RW(asset_open_rw(entry->path), 1);
+        }
+    }
+
+    SDL_AtomicSet(&residency.prefetch_done, 1);
+    return 0;
+}
+
+static void residency_collect_prefetch(SDL_Renderer *render) {
+    if (!residency.prefetch_thread) return;
+
+    SDL_WaitThread(residency.prefetch_thread, NULL);
+    residency.prefetch_thread = NULL;
+
+    int loaded = residency_load(render, residency.prefetch_state);
+    residency.prefetched += loaded;
+}
+
+void residency_update(SDL_Renderer *render, int state) {
+    if (residency.prefetch_thread && SDL_AtomicGet(&residency.prefetch_done)) {
+        residency_collect_prefetch(render);
+    }
+    if (state == residency.state) return;
+
+    residency_collect_prefetch(render);
+    int loaded = residency_load(render, state);
+    int evicted = residency_evict(state);
+    residency.state = state;
+    residency.prefetch_state = -1;
+
+    if (print_stats) {
+        printf("Residency: state %d, %d assets loaded on entry (%d prefetched so far, %d faults), %d evicted, %.1f MB of textures resident.\n",
+               state, loaded, residency.prefetched, residency.faults, evicted, residency.resident_bytes / (1024.0 * 1024.0));
+    }
+}
+
+static bool residency_fault(SDL_Renderer *render, Sprite *sprite) {
+    if (!sprite->resident) return false;
+
+    // Sprite usado fora do grupo previsto: carrega na hora e conta a falha.
+    residency_collect_prefetch(render);
+    if (!residency.textures[sprite->resident - 1].texture) {
+        residency_upload(render, sprite->resident - 1, NULL);
+        residency.faults++;
+    }
+
+    return sprite->texture != NULL;
+}
+
+void residency_shutdown(void) {
+    if (residency.prefetch_thread) {
+        SDL_WaitThread(residency.prefetch_thread, NULL);
+    }
+
+    for (int i = 0; i < residency.texture_count; i++) {
+        if (residency.textures[i].pending) SDL_FreeSurface(residency.textures[i].pending);
+        free(residency.textures[i].path);
+    }
+    for (int i = 0; i < residency.sound_count; i++) {
+        if (residency.sounds[i].pending) Mix_FreeChunk(residency.sounds[i].pending);
+        free(residency.sounds[i].placeholder);
+        free(residency.sounds[i].path);
+    }
+    free(residency.textures);
+    free(residency.sounds);
+
+    int startup_state = residency.startup_state;
+    memset(&residency, 0, sizeof(residency));
+    residency.state = residency.prefetch_state = -1;
+    residency.startup_state = startup_state;
+}
+
+void loader_start(int thread_count) {
+    loader.start_ticks = SDL_GetPerformanceCounter();
+    loader.started = true;
+    if (thread_count <= 0) return;
+    if (thread_count > LOADER_MAX_THREADS) thread_count = LOADER_MAX_THREADS;
+
+    char **paths = NULL;
+    int path_count = 0, path_capacity = 0;
+
+    // Páginas de atlas e sprites soltos: sprites já empacotados não precisam ser decodificados.
+    for (int i = 0; i < atlas_page_count; i++) {
+        if (path_count >= path_capacity) {
+            int capacity = path_capacity ? path_capacity * 2 : 128;
+            char **grown = realloc(paths, capacity * sizeof(*paths));
+            if (!grown) break;
+            paths = grown;
+            path_capacity = capacity;
+        }
+        if (residency_deferred(atlas_page_states(i))) continue;
+        paths[path_count++] = strdup(atlas_page_paths[i]);
+    }
+
+    int image_count = path_count;
+    asset_list(SPRITES_DIR, ".png", &paths, &path_count, &path_capacity);
+    for (int i = image_count; i < path_count; i++) {
+        // Só o grupo do estado inicial é decodificado na partida; o resto vem com a residência.
+        if (atlas_find(paths[i]) || residency_deferred(residency_states(paths[i]))) {
+            free(paths[i]);
+            continue;
+        }
+        paths[image_count++] = paths[i];
+    }
+    path_count = image_count;
+    int sound_start = path_count;
+    asset_list(SOUNDS_DIR, ".wav", &paths, &path_count, &path_capacity);
+    for (int i = sound_start; i < path_count; i++) {
+        if (is_streamed_music(paths[i]) || residency_deferred(residency_states(paths[i]))) {
+            free(paths[i]);
+            continue;
+        }
+        paths[sound_start++] = paths[i];
+    }
+    path_count = sound_start;
+
+    loader.jobs = calloc(path_count ? path_count : 1, sizeof(LoadJob));
+    loader.slot_capacity = 64;
+    while (loader.slot_capacity < path_count * 2) loader.slot_capacity *= 2;
+    loader.slots = calloc(loader.slot_capacity, sizeof(*loader.slots));
+    loader.mutex = SDL_CreateMutex();
+    loader.job_done = SDL_CreateCond();
+
+    if (!loader.jobs || !loader.slots || !loader.mutex || !loader.job_done) {
+        fprintf(stderr, "Error starting asset loader: %s\n", SDL_GetError());
+        for (int i = 0; i < path_count; i++) {
+            free(paths[i]);
+        }
+        free(paths);
+        loader_finish();
+        loader.started = true;
+        return;
+    }
+
+    for (int i = 0; i < path_count; i++) {
+        loader.jobs[i].path = paths[i];
+        loader.jobs[i].bytes = asset_size(paths[i]);
+        loader.jobs[i].is_audio = (i >= image_count);
+    }
+    free(paths);
+
+    // Maiores primeiro: as decodificações longas começam cedo em vez de ficarem para o fim da fila.
+    qsort(loader.jobs, path_count, sizeof(LoadJob), load_job_cmp);
+    for (int i = 0; i < path_count; i++) {
+        Uint32 slot = hash_string(loader.jobs[i].path) & (loader.slot_capacity - 1);
+        while (loader.slots[slot]) slot = (slot + 1) & (loader.slot_capacity - 1);
+        loader.slots[slot] = i + 1;
+    }
+    loader.job_count = path_count;
+
+    SDL_AtomicSet(&loader.next_job, 0);
+    for (int i = 0; i < thread_count; i++) {
+        SDL_Thread *thread = SDL_CreateThread(loader_worker, "asset-loader", NULL);
+        if (!thread) {
+            fprintf(stderr, "Error creating loader thread: %s\n", SDL_GetError());
+            break;
+        }
+        loader.threads[loader.thread_count++] = thread;
+    }
+}
+
+static LoadJob *loader_wait(const char *path) {
+    if (!loader.slots) return NULL;
+
+    LoadJob *job = NULL;
+    Uint32 slot = hash_string(path) & (loader.slot_capacity - 1);
+    while (loader.slots[slot]) {
+        LoadJob *candidate = &loader.jobs[loader.slots[slot] - 1];
+        if (strcmp(candidate->path, path) == 0) {
+            job = candidate;
+            break;
+        }
+        slot = (slot + 1) & (loader.slot_capacity - 1);
+    }
+    if (!job) return NULL;
+    job->requested = true;
+
+    // Sem threads ativas ninguém concluiria a tarefa; o chamador carrega sozinho.
+    if (loader.thread_count == 0) return NULL;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_LockMutex(loader.mutex);
+    while (!job->done) {
+        SDL_CondWait(loader.job_done, loader.mutex);
+    }
+    SDL_UnlockMutex(loader.mutex);
+    loader.wait_ticks += SDL_GetPerformanceCounter() - start;
+
+    return job;
+}
+
+static SDL_Surface *loader_surface(const char *path, Uint64 *content_hash) {
+    LoadJob *job = loader_wait(path);
+    if (!job || job->is_audio) return NULL;
+
+    if (content_hash) *content_hash = job->content_hash;
+    // A superfície fica com o carregador até loader_finish, pois o mesmo arquivo pode ser pedido mais de uma vez.
+    return job->surface;
+}
+
+static Mix_Chunk *loader_chunk(const char *path) {
+    LoadJob *job = loader_wait(path);
+    if (!job || !job->is_audio) return NULL;
+
+    // O chunk passa a ser do chamador; pedidos repetidos carregam uma nova cópia.
+    Mix_Chunk *chunk = job->chunk;
+    job->chunk = NULL;
+    return chunk;
+}
+
+static int loader_worker(void *data) {
+    (void) data;
+    trace_name_thread("asset-loader");
+
+    for (;;) {
+        int index = SDL_AtomicAdd(&loader.next_job, 1);
+        if (index >= loader.job_count) break;
+
+        TRACE_ZONE("loader_decode");
+        LoadJob *job = &loader.jobs[index];
+        Uint64 start = SDL_GetPerformanceCounter();
+        size_t bytes = 0;
+        if (job->is_audio) {
+            job->chunk = Mix_LoadWAV_RW(asset_open_rw(job->path), 1);
+            if (job->chunk) bytes = job->chunk->alen;
+        }
+        else {
+            job->surface = IMG_Load_RW(asset_open_rw(job->path), 1);
+            if (job->surface) {
+                bytes = (size_t)job->surface->pitch * job->surface->h;
+                job->content_hash = hash_surface(job->surface);
+            }
+        }
+        Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+        profile_record(job->path, "decode", start, bytes);
+
+        SDL_LockMutex(loader.mutex);
+        job->decode_ticks = elapsed;
+        job->done = true;
+        SDL_CondBroadcast(loader.job_done);
+        SDL_UnlockMutex(loader.mutex);
+    }
+
+    return 0;
+}
+
+void loader_finish(void) {
+    if (!loader.started) return;
+
+    for (int i = 0; i < loader.thread_count; i++) {
+        SDL_WaitThread(loader.threads[i], NULL);
+    }
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    double wall_ms = (SDL_GetPerformanceCounter() - loader.start_ticks) * 1000.0 / frequency;
+    Uint64 decode_ticks = 0;
+    int requested = 0;
+
+    for (int i = 0; i < loader.job_count; i++) {
+        LoadJob *job = &loader.jobs[i];
+        // Só os assets pedidos contam: o caminho serial nunca decodificaria os outros.
+        if (job->requested) {
+            decode_ticks += job->decode_ticks;
+            requested++;
+        }
+        if (job->surface) SDL_FreeSurface(job->surface);
+        if (job->chunk) Mix_FreeChunk(job->chunk);
+        free(job->path);
+    }
+
+    // O resumo só sai com --profile-startup (ou --benchmark-startup); o perfil ainda está ativo aqui.
+    if (profiler.enabled && loader.thread_count == 0) {
+        printf("Asset loading: serial, %.1f ms wall.\n", wall_ms);
+    }
+    else if (profiler.enabled) {
+        // No caminho serial toda a decodificação estaria na thread principal; aqui ela só paga o tempo de espera.
+        double decode_ms = decode_ticks * 1000.0 / frequency;
+        double wait_ms = loader.wait_ticks * 1000.0 / frequency;
+        printf("Asset loading: %d of %d decoded files requested on %d threads, %.1f ms wall "
+               "(requested decode %.1f ms summed, main thread waited %.1f ms, ~%.1f ms saved vs serial).\n",
+               requested, loader.job_count, loader.thread_count, wall_ms, decode_ms, wait_ms, decode_ms - wait_ms);
+    }
+
+    if (profiler.enabled) {
+        printf("Asset cache: %d textures (%d requests shared by path, %d by content), %d fonts (%d shared).\n",
+               texture_cache.count, texture_cache.hits, texture_cache.content_hits, font_cache.count, font_cache.hits);
+    }
+
+    if (loader.mutex) SDL_DestroyMutex(loader.mutex);
+    if (loader.job_done) SDL_DestroyCond(loader.job_done);
+    free(loader.jobs);
+    free(loader.slots);
+    memset(&loader, 0, sizeof(loader));
+}
+
+void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *player_state, int *game_state, double dt, Animation *meneghetti_face, Animation *python_face, double *anim_timer, Sound *sound, Prop *bubble_speech) {
+    TRACE_ZONE("create_dialogue");
+    const Uint8 *keys = player->keystate ? player->keystate : SDL_GetKeyboardState(NULL);
+    
+    bool has_meneghetti = (meneghetti_face != NULL);
+    bool has_python = (python_face != NULL);
+    bool bubble;
+    
+    static double anim_cooldown = 0.2;
+
+    static double e_cooldown = 0.0;
+    static bool prev_e_pressed = false;
+    e_cooldown += dt;
+    bool e_now = keys[SDL_SCANCODE_E];
+
+    static int counters[] = {0, 0};
+    
+    bool e_pressed = false;
+    if (e_now && !prev_e_pressed && e_cooldown >= 0.2) {
+        e_pressed = true;
+        e_cooldown = 0.0;
+    }
+
+    prev_e_pressed = e_now;
+    
+    int text_amount = 0;
+    for (int i = 0; i < MAX_DIALOGUE_STR; i++) {
+        if (text->writings[i] == NULL) break;
+        text_amount++;
+    }
+    const double timer_delay = 0.04;
+    
+    SDL_Rect dialogue_box = {0, 0, 0, 0};
+    if (bubble_speech) {
+        bubble_speech->collision = dialogue_box;
+        bubble = true;
+    }
+    else {
+        bubble = false;
+    }
+    switch(*game_state) {
+        case CUTSCENE:
+            dialogue_box = (SDL_Rect){20, SCREEN_HEIGHT - 200, SCREEN_WIDTH - 40, 180};
+            break;
+        case OPEN_WORLD:
+            if (player->collision.y + player->collision.h < SCREEN_HEIGHT / 2) {
+                dialogue_box = (SDL_Rect){25, SCREEN_HEIGHT - 175, SCREEN_WIDTH - 50, 150};
+            }
+            else {
+                dialogue_box = (SDL_Rect){25, 25, SCREEN_WIDTH - 50, 150};
+            }
+            break;
+        case BATTLE_SCREEN:
+            if (bubble) {
+                dialogue_box = (SDL_Rect){380, 40, bubble_speech->sprite->w * 1.5, bubble_speech->sprite->h * 1.5};
+            }
+            else {
+                dialogue_box = (SDL_Rect){20, SCREEN_HEIGHT / 2, SCREEN_WIDTH - 40, 132};
+            }
+            break;
+        case FINAL_SCREEN:
+            dialogue_box = (SDL_Rect){25, SCREEN_HEIGHT - 175, SCREEN_WIDTH - 50, 150};
             break;
         default:
             break;
     }
 
     if (*game_state != BATTLE_SCREEN) {
-        SDL_SetRenderDrawColor(render, 0, 0, 0, 255);
-        SDL_RenderFillRect(render, &dialogue_box);
+        render_set_color(render, 0, 0, 0, 255);
+        render_fill_rect(render, &dialogue_box);
     }
     if (bubble) {
-        SDL_RenderCopy(render, bubble_speech->texture, NULL, &dialogue_box);
+        render_sprite(render, bubble_speech->sprite, &dialogue_box);
     }
 
     // BORDAS:
     if (*game_state != CUTSCENE && *game_state != BATTLE_SCREEN && *game_state != FINAL_SCREEN) {
         SDL_Rect box_borders[] = {{dialogue_box.x, dialogue_box.y, dialogue_box.w, 5}, {dialogue_box.x, dialogue_box.y, 5, dialogue_box.h}, {dialogue_box.x, dialogue_box.y + dialogue_box.h - 5, dialogue_box.w, 5}, {dialogue_box.x + dialogue_box.w - 5, dialogue_box.y, 5, dialogue_box.h}};
-        SDL_SetRenderDrawColor(render, 255, 255, 255, 255);
-        SDL_RenderFillRects(render, box_borders, 4);
+        render_set_color(render, 255, 255, 255, 255);
+        render_fill_rects(render, box_borders, 4);
     }
 
     SDL_Rect meneghetti_frame = {dialogue_box.x + 27, dialogue_box.y + 27, 72, 96};
@@ -3199,205 +8273,105 @@ void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *p
         last_cur_str = text->cur_str;
     }
 
+    if (!text->atlas) text->atlas = glyph_atlas_get(render, text->text_font, text->text_color);
+
+    int max_x;
+    if (bubble) max_x = dialogue_box.x + dialogue_box.w - 2;
+    else max_x = dialogue_box.x + dialogue_box.w - 50;
+
+    int max_y;
+    if (*game_state != BATTLE_SCREEN) max_y = dialogue_box.y + dialogue_box.h - 27;
+    else if (bubble) max_y = dialogue_box.y + dialogue_box.h - 2;
+    else max_y = dialogue_box.y + dialogue_box.h;
+
+    // O LAYOUT SÓ É REFEITO QUANDO A STRING OU A CAIXA MUDAM:
+    SDL_Rect layout_box = {text->text_box.x, text->text_box.y, max_x - text->text_box.x, max_y - text->text_box.y};
+    TextLayout *layout = &text->layout;
+    if (layout->str != text->cur_str + 1 || memcmp(&layout->box, &layout_box, sizeof(SDL_Rect)) != 0) {
+        layout_dialogue(text, text->writings[text->cur_str], layout_box);
+        layout->str = text->cur_str + 1;
+    }
+    if (text->page >= layout->page_count) text->page = layout->page_count - 1;
+
+    int page_end = text->page + 1 < layout->page_count ? layout->page_start[text->page + 1] : layout->glyph_count;
+
     if (!text->waiting_for_input) {
         *anim_timer += dt;
         text->timer += dt;
         if (e_pressed && *game_state != BATTLE_SCREEN && !bubble) {
-            const char *current = text->writings[text->cur_str];
-            while (current[text->cur_byte] != '\0' && text->char_count < MAX_DIALOGUE_CHAR) {
-                char utf8_buffer[5];
-                int n = utf8_copy_char(&current[text->cur_byte], utf8_buffer);
-                SDL_Texture* t = create_text(render, utf8_buffer, text->text_font, text->text_color);
-                if (t) {
-                    text->chars[text->char_count] = t;
-                    strcpy(text->chars_string[text->char_count], utf8_buffer);
-                    text->char_count++;
-                }
-                text->cur_byte += n;
-            }
-            if(!bubble) text->waiting_for_input = true;
+            text->char_count = page_end;
+            text->waiting_for_input = true;
         }
         else if (text->timer >= timer_delay) {
             text->timer = 0.0;
-            const char *current = text->writings[text->cur_str];
-            
-            if (current[text->cur_byte] == '\0') {
-               if (!bubble) text->waiting_for_input = true;
+
+            if (text->char_count >= page_end) {
+                if (!bubble) text->waiting_for_input = true;
+                else if (text->page + 1 < layout->page_count) text->page++;
             }
             else {
-                if (text->char_count < MAX_DIALOGUE_CHAR) {
-                    char utf8_buffer[5];
-                    int n = utf8_copy_char(&current[text->cur_byte], utf8_buffer);
-                    SDL_Texture* t = create_text(render, utf8_buffer, text->text_font, text->text_color);
-                    if (t) {
-                        if (sound && sfx_timer >= sfx_cooldown) {
-                            int speaker = text->on_frame[text->cur_str];
-                            Mix_Chunk* chunk = NULL;
-                            
-                            if (speaker == MENEGHETTI || speaker == MENEGHETTI_ANGRY || speaker ==  MENEGHETTI_SAD) {
-                                chunk = sound[0].sound;
-                            }
-                            if (speaker == PYTHON) {
-                                chunk = sound[1].sound;
-                            }
-                            if (speaker == NONE) {
-                                chunk = sound[2].sound;
-                            }
-                            if (speaker == BUBBLE) {
-                                chunk = sound[3].sound;
-                            }
+                if (sound && sfx_timer >= sfx_cooldown) {
+                    int speaker = text->on_frame[text->cur_str];
+                    Mix_Chunk* chunk = NULL;
+                    
+                    if (speaker == MENEGHETTI || speaker == MENEGHETTI_ANGRY || speaker ==  MENEGHETTI_SAD) {
+                        chunk = sound[0].sound;
+                    }
+                    if (speaker == PYTHON) {
+                        chunk = sound[1].sound;
+                    }
+                    if (speaker == NONE) {
+                        chunk = sound[2].sound;
+                    }
+                    if (speaker == BUBBLE) {
+                        chunk = sound[3].sound;
+                    }
 
-                            if (chunk) {
-                                Mix_PlayChannel(DIALOGUE_CHANNEL, chunk, 0);
-                            }
-                            sfx_timer = 0.0;
-                        }
-                        text->chars[text->char_count] = t;
-                        strcpy(text->chars_string[text->char_count], utf8_buffer);
-                        text->char_count++;
+                    if (chunk) {
+                        Mix_PlayChannel(DIALOGUE_CHANNEL, chunk, 0);
                     }
-                    text->cur_byte += n;
+                    sfx_timer = 0.0;
                 }
+                text->char_count++;
             }
         }
+        text->cur_byte = text->char_count < layout->glyph_count ? layout->glyphs[text->char_count].byte : layout->byte_count;
     }
     else {
         if (e_pressed && !bubble) {
-            for (int i = 0; i < text->char_count; i++) {
-                if (text->chars[i]) {
-                    SDL_DestroyTexture(text->chars[i]);
-                    text->chars[i] = NULL;
-                }
-            }
-            text->char_count = 0;
-            text->cur_byte = 0;
-            text->cur_str++;
-
             text->waiting_for_input = false;
-            if (text->cur_str >= text_amount) {
-                reset_dialogue(text);
-                
-                if (*game_state == BATTLE_SCREEN) *player_state = IDLE;
-                else *player_state = MOVABLE;
-
-                return;
+            if (text->page + 1 < layout->page_count) {
+                text->page++;
             }
-        }
-    }
-
-    int pos_x = text->text_box.x;
-    int pos_y = text->text_box.y;
-
-    int max_x;
-    if (bubble) max_x = dialogue_box.x + dialogue_box.w - 2;
-    else max_x = dialogue_box.x + dialogue_box.w - 50;
-
-    int max_y;
-    if (*game_state != BATTLE_SCREEN) max_y = dialogue_box.y + dialogue_box.h - 27;
-    else if (bubble) max_y = dialogue_box.y + dialogue_box.h - 2;
-    else max_y = dialogue_box.y + dialogue_box.h;
-
-    int default_line_height = 16;
-    if (text->text_font) {
-        default_line_height = TTF_FontHeight(text->text_font);
-    } 
-    int line_height = 0;
-
-    for (int i = 0; i < text->char_count; i++) {
-        SDL_Texture* ct = text->chars[i];
-        if (!ct) continue;
-
-        int w, h;
-        SDL_QueryTexture(ct, NULL, NULL, &w, &h);
-        if (h > line_height) line_height = h;
-    }
-
-    int current_x = pos_x;
-    int current_y = pos_y;
-    int word_width = 0;
-    int word_start = -1;
-
-    for (int i = 0; i < text->char_count; i++) {
-        SDL_Texture* ct = text->chars[i];
-        if (!ct) continue;
-
-        int w, h;
-        SDL_QueryTexture(ct, NULL, NULL, &w, &h);
-        if (w == 0) w = 8;
-        if (h == 0) h = 16;
-
-        const char *chstr = text->chars_string[i];
-        bool is_space = (strcmp(chstr, " ") == 0);
-        bool is_newline = (strcmp(chstr, "|") == 0);
-
-        if (is_newline) {
-            word_start = -1;
-            word_width = 0;
-
-            current_x = pos_x;
-            current_y += (line_height > 0) ? line_height : default_line_height;
-            line_height = 0;
-            continue;
-        }
-
-        if (!is_space && word_start == -1) {
-            word_start = i;
-            word_width = 0;
-        }
-
-        if (!is_space) {
-            word_width += w;
-        }
-
-        if (is_space || i == text->char_count - 1) {
-            if (word_start != -1) {
-                if (current_x + word_width > max_x) {
-                    current_x = pos_x;
-                    current_y += (line_height > 0) ? line_height : default_line_height;
-                    line_height = 0;
-
-                    for (int j = word_start; j <= i; j++) {
-                        SDL_Texture* char_tex = text->chars[j];
-                        if (!char_tex) continue;
-
-                        int ch;
-                        SDL_QueryTexture(char_tex, NULL, NULL, NULL, &ch);
-                        if (ch > line_height) line_height = ch;
-                    }
-                }
-
-                for (int j = word_start; j <= i; j++) {
-                    SDL_Texture* char_tex = text->chars[j];
-                    if (!char_tex) continue;
-
-                    int cw, ch;
-                    SDL_QueryTexture(char_tex, NULL, NULL, &cw, &ch);
-                    SDL_Rect dst = {current_x, current_y, cw, ch};
-                    SDL_RenderCopy(render, char_tex, NULL, &dst);
-                    current_x += cw;
-                }
+            else {
+                text->char_count = 0;
+                text->cur_byte = 0;
+                text->page = 0;
+                text->cur_str++;
 
-                word_start = -1;
-                word_width = 0;
-            }
+                if (text->cur_str >= text_amount) {
+                    reset_dialogue(text);
+                    
+                    if (*game_state == BATTLE_SCREEN) *player_state = IDLE;
+                    else *player_state = MOVABLE;
 
-            if (is_space) {
-                if (current_x + w > max_x) {
-                    current_x = pos_x;
-                    current_y += (line_height > 0) ? line_height : default_line_height;
-                    line_height = h;
+                    return;
                 }
-
-                SDL_Rect dst = {current_x, current_y, w, h};
-                SDL_RenderCopy(render, ct, NULL, &dst);
-                current_x += w;
             }
         }
+    }
 
-        if (current_y + line_height > max_y) {
-            if (!bubble) text->waiting_for_input = true;
-            break;
+    // SÓ OS GLIFOS JÁ REVELADOS DA PÁGINA ATUAL SÃO DESENHADOS, NUM ÚNICO LOTE:
+    if (text->atlas && layout->str == text->cur_str + 1) {
+        const Glyph *glyphs = text->atlas->glyphs;
+        text_batch_begin(&text_batch, text->atlas);
+        for (int i = layout->page_start[text->page]; i < text->char_count && i < page_end; i++) {
+            const LaidGlyph *laid = &layout->glyphs[i];
+            if (laid->glyph < 0) continue;
+
+            text_batch_add(&text_batch, &glyphs[laid->glyph], text->text_box.x + laid->x, text->text_box.y + laid->y);
         }
+        text_batch_flush(render, &text_batch);
     }
 
     if (text->on_frame[text->cur_str] != NONE) {
@@ -3411,11 +8385,11 @@ void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *p
                             *anim_timer = 0.0;
                         }
                         
-                        SDL_RenderCopy(render, meneghetti_face[0].frames[counters[0] % meneghetti_face[0].count], NULL, &meneghetti_frame);
+                        render_sprite(render, meneghetti_face[0].frames[counters[0] % meneghetti_face[0].count], &meneghetti_frame);
                     }
                     else {
                         counters[0] = 0;
-                        SDL_RenderCopy(render, meneghetti_face[0].frames[0], NULL, &meneghetti_frame);
+                        render_sprite(render, meneghetti_face[0].frames[0], &meneghetti_frame);
                     }
                 }
                 break;
@@ -3428,11 +8402,11 @@ void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *p
                             *anim_timer = 0.0;
                         }
                         
-                        SDL_RenderCopy(render, meneghetti_face[1].frames[counters[0] % meneghetti_face[1].count], NULL, &meneghetti_frame);
+                        render_sprite(render, meneghetti_face[1].frames[counters[0] % meneghetti_face[1].count], &meneghetti_frame);
                     }
                     else {
                         counters[0] = 0;
-                        SDL_RenderCopy(render, meneghetti_face[1].frames[0], NULL, &meneghetti_frame);
+                        render_sprite(render, meneghetti_face[1].frames[0], &meneghetti_frame);
                     }
                 }
                 break;
@@ -3445,11 +8419,11 @@ void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *p
                             *anim_timer = 0.0;
                         }
                         
-                        SDL_RenderCopy(render, meneghetti_face[2].frames[counters[0] % meneghetti_face[2].count], NULL, &meneghetti_frame);
+                        render_sprite(render, meneghetti_face[2].frames[counters[0] % meneghetti_face[2].count], &meneghetti_frame);
                     }
                     else {
                         counters[0] = 0;
-                        SDL_RenderCopy(render, meneghetti_face[2].frames[0], NULL, &meneghetti_frame);
+                        render_sprite(render, meneghetti_face[2].frames[0], &meneghetti_frame);
                     }
                 }
                 break;
@@ -3462,11 +8436,11 @@ void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *p
                             *anim_timer = 0.0;
                         }
                         
-                        SDL_RenderCopy(render, python_face->frames[counters[0] % python_face->count], NULL, &python_frame);
+                        render_sprite(render, python_face->frames[counters[0] % python_face->count], &python_frame);
                     }
                     else {
                         counters[0] = 0;
-                        SDL_RenderCopy(render, python_face->frames[0], NULL, &python_frame);
+                        render_sprite(render, python_face->frames[0], &python_frame);
                     }
                 }
         }
@@ -3474,20 +8448,135 @@ void create_dialogue(Character *player, SDL_Renderer *render, Text *text, int *p
 }
 
 void reset_dialogue(Text *text) {
-    for (int i = 0; i < text->char_count; i++) {
-        if (text->chars[i]) {
-            SDL_DestroyTexture(text->chars[i]);
-            text->chars[i] = NULL;
-        }
-    }
     text->char_count = 0;
+    text->page = 0;
+    text->layout.str = 0;
     text->cur_str = 0;
     text->cur_byte = 0;
     text->timer = 0.0;
     text->waiting_for_input = false;
 }
 
+static bool layout_page_break(TextLayout *layout, int *y, int line_height) {
+    *y += line_height;
+    if (*y + line_height > layout->box.h) {
+        if (layout->page_count >= MAX_DIALOGUE_PAGES) return false;
+        layout->page_start[layout->page_count++] = layout->glyph_count;
+        *y = 0;
+    }
+    return true;
+}
+
+// TEXTO QUE NÃO CABE NAS PÁGINAS (OU EM MAX_DIALOGUE_CHAR) TERMINA EM "..." NA ÚLTIMA LINHA:
+static void layout_ellipsis(TextLayout *layout, GlyphAtlas *atlas, int byte) {
+    int dot = glyph_atlas_glyph(atlas, ".");
+    if (dot < 0) return;
+    int dot_w = atlas->glyphs[dot].rect.w;
+
+    int x = 0, y = 0;
+    int first = layout->page_start[layout->page_count - 1];
+    while (layout->glyph_count > first) {
+        const LaidGlyph *last = &layout->glyphs[layout->glyph_count - 1];
+        x = last->x + (last->glyph >= 0 ? atlas->glyphs[last->glyph].rect.w : 0);
+        y = last->y;
+        bool is_space = last->glyph >= 0 && atlas->glyphs[last->glyph].codepoint == ' ';
+        if (layout->glyph_count + 3 <= MAX_DIALOGUE_CHAR && !is_space && x + 3 * dot_w <= layout->box.w) break;
+
+        byte = last->byte;
+        layout->glyph_count--;
+        x = last->x;
+    }
+
+    for (int i = 0; i < 3 && layout->glyph_count < MAX_DIALOGUE_CHAR; i++) {
+        layout->glyphs[layout->glyph_count++] = (LaidGlyph){dot, x + i * dot_w, y, byte};
+    }
+}
+
+void layout_dialogue(Text *text, const char *writing, SDL_Rect box) {
+    TextLayout *layout = &text->layout;
+    layout->box = box;
+    layout->glyph_count = 0;
+    layout->page_start[0] = 0;
+    layout->page_count = 1;
+    layout->byte_count = writing ? (int)strlen(writing) : 0;
+    if (!writing || !text->atlas) return;
+
+    int line_height = text->text_font ? TTF_FontHeight(text->text_font) : 16;
+    int x = 0, y = 0;
+    int byte = 0;
+    bool in_word = false;
+    bool truncated = false;
+
+    while (!truncated && writing[byte] != '\0' && layout->glyph_count < MAX_DIALOGUE_CHAR) {
+        char utf8_buffer[5];
+        int n = utf8_copy_char(&writing[byte], utf8_buffer);
+        LaidGlyph *laid = &layout->glyphs[layout->glyph_count];
+        laid->byte = byte;
+        laid->glyph = -1;
+        byte += n;
+
+        // '|' QUEBRA A LINHA E CONTA NO RITMO DA MÁQUINA DE ESCREVER, MAS NÃO É DESENHADO:
+        if (utf8_buffer[0] == '|') {
+            laid->x = x;
+            laid->y = y;
+            layout->glyph_count++;
+            x = 0;
+            in_word = false;
+            truncated = !layout_page_break(layout, &y, line_height) && writing[byte] != '\0';
+            continue;
+        }
+
+        int glyph = glyph_atlas_glyph(text->atlas, utf8_buffer);
+        if (glyph < 0) continue;
+        int w = text->atlas->glyphs[glyph].rect.w;
+        bool is_space = utf8_buffer[0] == ' ';
+
+        // NO INÍCIO DE CADA PALAVRA, MEDE ATÉ O PRÓXIMO ESPAÇO E QUEBRA A LINHA ANTES SE NÃO COUBER:
+        if (!is_space && !in_word) {
+            in_word = true;
+            int word_width = w;
+            for (int b = byte; writing[b] != '\0' && writing[b] != ' ' && writing[b] != '|';) {
+                char next[5];
+                b += utf8_copy_char(&writing[b], next);
+                int next_glyph = glyph_atlas_glyph(text->atlas, next);
+                if (next_glyph >= 0) word_width += text->atlas->glyphs[next_glyph].rect.w;
+            }
+            if (x > 0 && x + word_width > box.w) {
+                x = 0;
+                if (!layout_page_break(layout, &y, line_height)) {
+                    truncated = true;
+                    byte -= n;
+                    break;
+                }
+            }
+        }
+        else if (is_space) {
+            in_word = false;
+            if (x + w > box.w) {
+                x = 0;
+                if (!layout_page_break(layout, &y, line_height)) {
+                    truncated = true;
+                    byte -= n;
+                    break;
+                }
+            }
+        }
+
+        laid->glyph = glyph;
+        laid->x = x;
+        laid->y = y;
+        layout->glyph_count++;
+        x += w;
+    }
+
+    if (truncated || writing[byte] != '\0') {
+        fprintf(stderr, "Dialogue text exceeds %d pages or %d characters, truncating: '%.40s'\n", MAX_DIALOGUE_PAGES, MAX_DIALOGUE_CHAR, writing);
+        layout_ellipsis(layout, text->atlas, byte);
+    }
+}
+
 void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *player_health, int damage, int attack_index, bool *ivulnerable, Projectile **props, double dt, double turn_timer, Sound *sound, bool clear) {
+    TRACE_ZONE("python_attacks");
     static double spawn_timer = 0.0;
     static int objects_spawned = 0;
     static bool attack_active = false;
@@ -3524,10 +8613,10 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                     if (attack_index == 4) {
                         alpha_counter += dt * 300;
                         if (alpha_counter >= 255) alpha_counter = 255;
-                        SDL_SetTextureAlphaMod(props[3][0].animation.frames[0], alpha_counter);
-                        SDL_SetTextureAlphaMod(props[3][1].animation.frames[0], alpha_counter);
-                        SDL_SetTextureAlphaMod(props[3][0].animation.frames[1], alpha_counter);
-                        SDL_SetTextureAlphaMod(props[3][1].animation.frames[1], alpha_counter);
+                        sprite_set_alpha(props[3][0].animation.frames[0], alpha_counter);
+                        sprite_set_alpha(props[3][1].animation.frames[0], alpha_counter);
+                        sprite_set_alpha(props[3][0].animation.frames[1], alpha_counter);
+                        sprite_set_alpha(props[3][1].animation.frames[1], alpha_counter);
                         if (!played_appear_sound) {
                             Mix_PlayChannel(DEFAULT_CHANNEL, appear_sound, 0);
                             played_appear_sound = true;
@@ -3555,11 +8644,11 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                 }
 
                 if (attack_index == 4) {
-                    props[3][0].texture = animate_sprite(&props[3][0].animation, dt, 0.4, false);
-                    props[3][1].texture = animate_sprite(&props[3][1].animation, dt, 0.4, false);
+                    props[3][0].sprite = animate_sprite(&props[3][0].animation, dt, 0.4, false);
+                    props[3][1].sprite = animate_sprite(&props[3][1].animation, dt, 0.4, false);
 
-                    SDL_RenderCopyF(render, props[3][0].texture, NULL, &props[3][0].collision);
-                    SDL_RenderCopyF(render, props[3][1].texture, NULL, &props[3][1].collision);
+                    render_sprite_f(render, props[3][0].sprite, &props[3][0].collision);
+                    render_sprite_f(render, props[3][1].sprite, &props[3][1].collision);
 
                     if (!*ivulnerable && rects_intersect(&soul->collision, NULL, &props[3][0].collision)) {
                         Mix_PlayChannel(DEFAULT_CHANNEL, hit_sound, 0);
@@ -3581,6 +8670,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                             Mix_PlayChannel(DEFAULT_CHANNEL, appear_sound, 0);
                             int random_object = randint(0, 5);
                             active_objects[i] = props[0][random_object];
+                            render_queue_forget(&active_objects[i].collision);
 
                             active_objects[i].collision.x = randint(battle_box.x, (battle_box.x + battle_box.w));
                             active_objects[i].collision.y = battle_box.y;
@@ -3613,7 +8703,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                             continue;
                         }
 
-                        SDL_RenderCopyExF(render, active_objects[i].texture, NULL, &active_objects[i].collision, 90, NULL, 0);
+                        render_sprite_exf(render, active_objects[i].sprite, &active_objects[i].collision, 90, SDL_FLIP_NONE);
                     }
                 }
 
@@ -3657,6 +8747,8 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
 
                             active_objects[i] = props[1][pair_type];
                             active_objects[i + 1] = props[1][pair_type + 1];
+                            render_queue_forget(&active_objects[i].collision);
+                            render_queue_forget(&active_objects[i + 1].collision);
 
                             active_objects[i].collision.x = soul->collision.x - active_objects[i].collision.w - 80;
                             active_objects[i].collision.y = soul->collision.y;
@@ -3710,7 +8802,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                             continue;
                         }
 
-                        SDL_RenderCopyExF(render, active_objects[i].texture, NULL, &active_objects[i].collision, 0, NULL, 0);
+                        render_sprite_exf(render, active_objects[i].sprite, &active_objects[i].collision, 0, SDL_FLIP_NONE);
                     }
                 }
 
@@ -3737,7 +8829,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                 if (!attack_active && turn_timer <= 8.0) {
                     alpha_counter += dt * 300;
                     if (alpha_counter >= 255) alpha_counter = 255;
-                    SDL_SetTextureAlphaMod(props[2][0].texture, alpha_counter);
+                    sprite_set_alpha(props[2][0].sprite, alpha_counter);
                     if (!played_appear_sound) {
                         Mix_PlayChannel(DEFAULT_CHANNEL, appear_sound, 0);
                         played_appear_sound = true;
@@ -3747,7 +8839,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                     props[2][0].collision.y = battle_box.y + 10;
 
                     if (turn_timer >= 2.0) {
-                        props[2][0].texture = props[2][1].texture;
+                        props[2][0].sprite = props[2][1].sprite;
 
                         attack_active = true;
                         spawn_timer = 0.0;
@@ -3759,8 +8851,8 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                     }
                 }
 
-                SDL_RenderCopyF(render, props[2][0].texture, NULL, &props[2][0].collision);
-                SDL_RenderCopy(render, soul->texture, NULL, &soul->collision);
+                render_sprite_f(render, props[2][0].sprite, &props[2][0].collision);
+                render_sprite(render, soul->sprite, &soul->collision);
 
                 spawn_timer += dt;
 
@@ -3769,6 +8861,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                         if (!created_object[i]) {
                             Mix_PlayChannel(DEFAULT_CHANNEL, born_sound, 0);
                             active_objects[i] = props[2][2];
+                            render_queue_forget(&active_objects[i].collision);
 
                             active_objects[i].collision.x = (props[2][0].collision.x + (props[2][0].collision.w / 2)) - (active_objects[i].collision.w / 2);
                             active_objects[i].collision.y = (props[2][0].collision.y + (props[2][0].collision.h / 2)) - (active_objects[i].collision.h / 2);
@@ -3796,7 +8889,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                 for (int i = 0; i < 15; i++) {
                     if (created_object[i]) {
 
-                        active_objects[i].texture = animate_sprite(&active_objects->animation, dt, 0.2, false);
+                        active_objects[i].sprite = animate_sprite(&active_objects->animation, dt, 0.2, false);
                             
                         active_objects[i].collision.x += vel_x[i] * dt;
                         active_objects[i].collision.y += vel_y[i] * dt;
@@ -3815,7 +8908,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
                             continue;
                         }
 
-                        SDL_RenderCopyExF(render, active_objects[i].texture, NULL, &active_objects[i].collision, angles[i] + 90, NULL, 0);
+                        render_sprite_exf(render, active_objects[i].sprite, &active_objects[i].collision, angles[i] + 90, SDL_FLIP_NONE);
                     }
                 }
 
@@ -3860,6 +8953,7 @@ void python_attacks(SDL_Renderer *render, Prop *soul, SDL_Rect battle_box, int *
 }
 
 void sprite_update(Character *scenario, Character *player, Animation *animation, double dt, SDL_Rect boxes[], SDL_Rect surfaces[], double *anim_timer, double anim_interval, Sound *sound) {
+    TRACE_ZONE("sprite_update");
     const Uint8 *keys = player->keystate ? player->keystate : SDL_GetKeyboardState(NULL);
 
     SDL_Rect feet = {player->collision.x, player->collision.y + 29, player->collision.w, 3};
@@ -3986,28 +9080,28 @@ void sprite_update(Character *scenario, Character *player, Animation *animation,
 
     if (moving_up) {
         if (*anim_timer >= anim_interval) {
-            player->texture = animation[UP].frames[ player->counters[UP] % animation[UP].count ];
+            player->sprite = animation[UP].frames[ player->counters[UP] % animation[UP].count ];
             player->counters[UP] = (player->counters[UP] + 1) % animation[UP].count;
             *anim_timer = 0.0;
         }
     }
     else if (moving_down) {
         if (*anim_timer >= anim_interval) {
-            player->texture = animation[DOWN].frames[ player->counters[DOWN] % animation[DOWN].count ];
+            player->sprite = animation[DOWN].frames[ player->counters[DOWN] % animation[DOWN].count ];
             player->counters[DOWN] = (player->counters[DOWN] + 1) % animation[DOWN].count;
             *anim_timer = 0.0;
         }
     }
     else if (moving_left) {
         if (*anim_timer >= anim_interval) {
-            player->texture = animation[LEFT].frames[ player->counters[LEFT] % animation[LEFT].count ];
+            player->sprite = animation[LEFT].frames[ player->counters[LEFT] % animation[LEFT].count ];
             player->counters[LEFT] = (player->counters[LEFT] + 1) % animation[LEFT].count;
             *anim_timer = 0.0;
         }
     }
     else if (moving_right) {
         if (*anim_timer >= anim_interval) {
-            player->texture = animation[RIGHT].frames[ player->counters[RIGHT] % animation[RIGHT].count ];
+            player->sprite = animation[RIGHT].frames[ player->counters[RIGHT] % animation[RIGHT].count ];
             player->counters[RIGHT] = (player->counters[RIGHT] + 1) % animation[RIGHT].count;
             *anim_timer = 0.0;
         }
@@ -4017,7 +9111,7 @@ void sprite_update(Character *scenario, Character *player, Animation *animation,
 
         int face = player->facing;
         if (face < 0 || face >= DIR_COUNT) face = DOWN;
-        player->texture = animation[face].frames[0];
+        player->sprite = animation[face].frames[0];
     }
 
     static int current_walk_sound = -1;
@@ -4046,7 +9140,8 @@ void sprite_update(Character *scenario, Character *player, Animation *animation,
     }
 }
 
-SDL_Texture *animate_sprite(Animation *anim, double dt, double cooldown, bool blink) {
+Sprite *animate_sprite(Animation *anim, double dt, double cooldown, bool blink) {
+    TRACE_ZONE("animate_sprite");
     if (!anim || anim->count <= 0) return NULL;
 
     if (cooldown <= 0.0) {
@@ -4145,6 +9240,7 @@ bool rects_intersect(SDL_Rect *a, SDL_Rect *b, SDL_FRect *c) {
 }
 
 bool check_collision(SDL_Rect *player, SDL_Rect boxes[], int box_count) {
+    TRACE_ZONE("check_collision");
     for (int i = 0; i < box_count; i++) {
         if (rects_intersect(player, &boxes[i], NULL)) return true;
     }
@@ -4165,6 +9261,7 @@ static int surface_to_sound_index(int surface_index) {
 }
 
 static int detect_surface(SDL_Rect *player, SDL_Rect surfaces[], int surface_count) {
+    TRACE_ZONE("detect_surface");
     SDL_Rect feet = {player->x, player->y + 29, player->w, 3};
 
     int best_index = -1;
@@ -4197,7 +9294,7 @@ void update_reflection(Character *original, Character* reflection, Animation *an
 
     int current_frame = original->counters[original->facing];
 
-    reflection->texture = animation[reflection->facing].frames[current_frame];
+    reflection->sprite = animation[reflection->facing].frames[current_frame];
 
     reflection->collision.x = original->collision.x;
     reflection->collision.y = original->collision.y + original->collision.h;
@@ -4208,7 +9305,7 @@ void update_reflection(Character *original, Character* reflection, Animation *an
 void organize_items(Prop *text_items) {
     int available = 0;
     for (int i = 0; i < 4; i++) {
-        if (text_items[i].texture != NULL) available++;
+        if (text_items[i].sprite != NULL) available++;
     }
     if (available == 4) return;
 
@@ -4217,7 +9314,7 @@ void organize_items(Prop *text_items) {
 
     int base_y = -1;
     for (int i = 0; i < 4; i++) {
-        if (text_items[i].texture != NULL) {
+        if (text_items[i].sprite != NULL) {
             base_y = (SCREEN_HEIGHT / 2) + 25;
             break;
         }
@@ -4230,10 +9327,10 @@ void organize_items(Prop *text_items) {
     Prop *col2[2] = {NULL, NULL};
     int col2_count = 0;
 
-    if (text_items[0].texture != NULL) col1[col1_count++] = &text_items[0];
-    if (text_items[1].texture != NULL) col1[col1_count++] = &text_items[1];
-    if (text_items[2].texture != NULL) col2[col2_count++] = &text_items[2];
-    if (text_items[3].texture != NULL) col2[col2_count++] = &text_items[3];
+    if (text_items[0].sprite != NULL) col1[col1_count++] = &text_items[0];
+    if (text_items[1].sprite != NULL) col1[col1_count++] = &text_items[1];
+    if (text_items[2].sprite != NULL) col2[col2_count++] = &text_items[2];
+    if (text_items[3].sprite != NULL) col2[col2_count++] = &text_items[3];
 
     int current_y = base_y;
     for (int i = 0; i < 2; i++) {
@@ -4266,7 +9363,7 @@ void organize_items(Prop *text_items) {
 
     Prop tmp[4];
     for (int i = 0; i < 4; i++) {
-        tmp[i].texture = NULL;
+        tmp[i].sprite = NULL;
         tmp[i].collision = (SDL_Rect){0, 0, 0, 0};
     }
 
@@ -4288,73 +9385,327 @@ void organize_items(Prop *text_items) {
     }
 }
 
-static void track_texture(SDL_Texture *texture) {
-    if (!texture || already_tracked_texture(texture)) {
-        return;
+static Uint32 resource_slot_hash(const void *pointer) {
+    uintptr_t bits = (uintptr_t)pointer;
+    return (Uint32)((bits >> 4) ^ (bits >> 20)) * 2654435761u;
+}
+
+static int resource_find_index(const void *pointer) {
+    if (!registry.index) return -1;
+
+    // -1 marca entradas removidas (lápides); a busca continua até um espaço vazio.
+    Uint32 mask = registry.index_capacity - 1;
+    Uint32 position = resource_slot_hash(pointer) & mask;
+    registry.lookups++;
+    while (registry.index[position]) {
+        registry.probes++;
+        int slot = registry.index[position] - 1;
+        if (slot >= 0 && registry.slots[slot].pointer == pointer) return (int)position;
+        position = (position + 1) & mask;
     }
 
-    if (guarded_textures_count >= guarded_textures_capacity) {
-        guarded_textures_capacity = guarded_textures_capacity ? guarded_textures_capacity * 2 : 64;
-        guarded_textures = realloc(guarded_textures, guarded_textures_capacity * sizeof(*guarded_textures));
+    return -1;
+}
+
+static void resource_grow_index(void) {
+    int capacity = registry.index_capacity ? registry.index_capacity : 256;
+    int live = registry.index_used - registry.tombstones;
+    while (live * 2 >= capacity) capacity *= 2;
+
+    int *index = calloc(capacity, sizeof(*index));
+    if (!index) return;
+
+    for (int i = 0; i < registry.slot_count; i++) {
+        if (!registry.slots[i].pointer) continue;
+
+        Uint32 position = resource_slot_hash(registry.slots[i].pointer) & (capacity - 1);
+        while (index[position]) position = (position + 1) & (capacity - 1);
+        index[position] = i + 1;
     }
 
-    guarded_textures[guarded_textures_count++] = texture;
+    free(registry.index);
+    registry.index = index;
+    registry.index_capacity = capacity;
+    registry.index_used = live;
+    registry.tombstones = 0;
 }
 
-static bool already_tracked_texture(SDL_Texture *texture) {
-    for (int i = 0; i < guarded_textures_count; i++) {
-        if (guarded_textures[i] == texture) {
-            return true;
+static ResourceHandle resource_register(void *pointer, int kind) {
+    if (!pointer) return (ResourceHandle){0, 0};
+
+    // Registrar de novo o mesmo ponteiro devolve o handle existente, sem somar referência.
+    int position = resource_find_index(pointer);
+    if (position >= 0) {
+        int slot = registry.index[position] - 1;
+        return (ResourceHandle){slot + 1, registry.slots[slot].generation};
+    }
+
+    if ((registry.index_used + 1) * 10 > registry.index_capacity * 7) resource_grow_index();
+    if (!registry.index) return (ResourceHandle){0, 0};
+
+    int slot = registry.free_head;
+    if (slot >= 0) {
+        registry.free_head = registry.slots[slot].next_free;
+    }
+    else {
+        if (registry.slot_count >= registry.slot_capacity) {
+            int capacity = registry.slot_capacity ? registry.slot_capacity * 2 : 256;
+            ResourceSlot *slots = realloc(registry.slots, capacity * sizeof(*slots));
+            if (!slots) return (ResourceHandle){0, 0};
+            registry.slots = slots;
+            registry.slot_capacity = capacity;
         }
+        slot = registry.slot_count++;
+        registry.slots[slot].generation = 1;
     }
 
-    return false;
+    ResourceSlot *entry = &registry.slots[slot];
+    entry->pointer = pointer;
+    entry->kind = kind;
+    entry->refcount = 1;
+    resource_describe(entry);
+    entry->next_free = -1;
+
+    Uint32 mask = registry.index_capacity - 1;
+    Uint32 index_position = resource_slot_hash(pointer) & mask;
+    while (registry.index[index_position] > 0) index_position = (index_position + 1) & mask;
+    if (registry.index[index_position] == 0) registry.index_used++;
+    else registry.tombstones--;
+    registry.index[index_position] = slot + 1;
+
+    registry.live[kind]++;
+    registry.bytes[kind] += entry->bytes;
+    if (registry.live[kind] > registry.peak[kind]) registry.peak[kind] = registry.live[kind];
+    registry.registrations++;
+    resource_mark_state();
+
+    return (ResourceHandle){slot + 1, entry->generation};
 }
 
-static void track_chunk(Mix_Chunk *chunk) {
-    if (!chunk || already_tracked_chunk(chunk)) {
-        return;
+void *resource_get(ResourceHandle handle) {
+    if (handle.slot == 0 || handle.slot > (Uint32)registry.slot_count) return NULL;
+
+    ResourceSlot *entry = &registry.slots[handle.slot - 1];
+    return entry->generation == handle.generation ? entry->pointer : NULL;
+}
+
+void resource_retain(void *pointer) {
+    int position = resource_find_index(pointer);
+    if (position >= 0) registry.slots[registry.index[position] - 1].refcount++;
+}
+
+static void resource_destroy(void *pointer, int kind) {
+    switch (kind) {
+    case RESOURCE_TEXTURE:
+        SDL_DestroyTexture(pointer);
+        break;
+    case RESOURCE_CHUNK:
+        Mix_FreeChunk(pointer);
+        break;
+    case RESOURCE_FONT:
+        TTF_CloseFont(pointer);
+        break;
+    case RESOURCE_MUSIC:
+        Mix_FreeMusic(pointer);
+        break;
+    default:
+        break;
     }
+}
+
+bool resource_release(void *pointer) {
+    if (!pointer) return false;
 
-    if (guarded_chunks_count >= guarded_chunks_capacity) {
-        guarded_chunks_capacity = guarded_chunks_capacity ? guarded_chunks_capacity * 2 : 64;
-        guarded_chunks = realloc(guarded_chunks, guarded_chunks_capacity * sizeof(*guarded_chunks));
+    int position = resource_find_index(pointer);
+    if (position < 0) {
+        fprintf(stderr, "Warning: releasing untracked resource %p\n", pointer);
+        return false;
     }
 
-    guarded_chunks[guarded_chunks_count++] = chunk;
+    int slot = registry.index[position] - 1;
+    ResourceSlot *entry = &registry.slots[slot];
+    if (--entry->refcount > 0) return false;
+
+    resource_destroy(entry->pointer, entry->kind);
+    registry.live[entry->kind]--;
+    registry.bytes[entry->kind] -= entry->bytes;
+    registry.releases++;
+
+    // Nova geração: handles antigos para este slot passam a resolver para NULL.
+    entry->pointer = NULL;
+    entry->generation++;
+    entry->next_free = registry.free_head;
+    registry.free_head = slot;
+
+    registry.index[position] = -1;
+    registry.tombstones++;
+    return true;
 }
 
-static bool already_tracked_chunk(Mix_Chunk *chunk) {
-    for (int i = 0; i < guarded_chunks_count; i++) {
-        if (guarded_chunks[i] == chunk) {
-            return true;
-        }
+ResourceStats resource_stats(void) {
+    ResourceStats stats = {0};
+    for (int kind = 0; kind < RESOURCE_KIND_COUNT; kind++) {
+        stats.live[kind] = registry.live[kind];
+        stats.peak[kind] = registry.peak[kind];
+        stats.bytes[kind] = registry.bytes[kind];
     }
+    stats.registrations = registry.registrations;
+    stats.releases = registry.releases;
+    stats.average_probes = registry.lookups ? (double)registry.probes / registry.lookups : 0.0;
 
-    return false;
+    return stats;
 }
 
-static void track_font(TTF_Font *font) {
-    if (!font || already_tracked_font(font)) {
-        return;
+static void resource_describe(ResourceSlot *entry) {
+    entry->w = entry->h = 0;
+    entry->format = 0;
+    entry->bytes = 0;
+    entry->name[0] = '\0';
+
+    if (entry->kind == RESOURCE_TEXTURE) {
+        SDL_QueryTexture(entry->pointer, &entry->format, NULL, &entry->w, &entry->h);
+        int bytes_per_pixel = SDL_BYTESPERPIXEL(entry->format);
+        entry->bytes = (size_t)entry->w * entry->h * (bytes_per_pixel > 0 ? bytes_per_pixel : 4);
     }
+    else if (entry->kind == RESOURCE_CHUNK) {
+        entry->bytes = ((Mix_Chunk *)entry->pointer)->alen;
+    }
+}
+
+void resource_account(void *pointer, size_t bytes) {
+    int position = resource_find_index(pointer);
+    if (position < 0) return;
+
+    ResourceSlot *entry = &registry.slots[registry.index[position] - 1];
+    registry.bytes[entry->kind] += bytes - entry->bytes;
+    entry->bytes = bytes;
+    resource_mark_state();
+}
+
+void resource_name(void *pointer, const char *name) {
+    int position = resource_find_index(pointer);
+    if (position < 0 || !name) return;
+
+    ResourceSlot *entry = &registry.slots[registry.index[position] - 1];
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+}
 
-    if (guarded_fonts_count >= guarded_fonts_capacity) {
-        guarded_fonts_capacity = guarded_fonts_capacity ? guarded_fonts_capacity * 2 : 32;
-        guarded_fonts = realloc(guarded_fonts, guarded_fonts_capacity * sizeof(*guarded_fonts));
+static void resource_mark_state(void) {
+    if (registry.state < 0 || registry.state > RESOURCE_STATE_STARTUP) return;
+
+    for (int kind = 0; kind < RESOURCE_KIND_COUNT; kind++) {
+        if (registry.live[kind] > registry.state_peak[registry.state][kind]) registry.state_peak[registry.state][kind] = registry.live[kind];
+        if (registry.bytes[kind] > registry.state_peak_bytes[registry.state][kind]) registry.state_peak_bytes[registry.state][kind] = registry.bytes[kind];
     }
+}
 
-    guarded_fonts[guarded_fonts_count++] = font;
+void resource_set_state(int state) {
+    registry.state = state;
+    resource_mark_state();
 }
 
-static bool already_tracked_font(TTF_Font *font) {
-    for (int i = 0; i < guarded_fonts_count; i++) {
-        if (guarded_fonts[i] == font) {
-            return true;
+static const char *resource_state_name(int state) {
+    return state == RESOURCE_STATE_STARTUP ? "startup" : game_state_names[state];
+}
+
+int resource_overlay(SDL_Renderer *render, GlyphAtlas *atlas, int x, int y) {
+    if (!atlas) return y;
+
+    int line_height = atlas->font ? TTF_FontLineSkip(atlas->font) : 16;
+    char line[128];
+    SDL_Rect background = {x - 4, y - 2, 300, line_height * (3 + GAME_STATE_COUNT) + 4};
+    SDL_BlendMode previous_blend = render_queue.blend;
+    render_set_color(render, 0, 0, 0, 200);
+    render_set_blend(render, SDL_BLENDMODE_BLEND);
+    render_fill_rect(render, &background);
+    render_set_blend(render, previous_blend);
+
+    text_batch_begin(&text_batch, atlas);
+    snprintf(line, sizeof(line), "VRAM %.1f MB  %d textures", registry.bytes[RESOURCE_TEXTURE] / 1048576.0, registry.live[RESOURCE_TEXTURE]);
+    text_batch_string(&text_batch, line, x, y);
+    y += line_height;
+
+    size_t ram = registry.bytes[RESOURCE_CHUNK] + registry.bytes[RESOURCE_FONT] + registry.bytes[RESOURCE_MUSIC];
+    snprintf(line, sizeof(line), "RAM %.1f MB  %d chunks  %d fonts  %d music", ram / 1048576.0,
+             registry.live[RESOURCE_CHUNK], registry.live[RESOURCE_FONT], registry.live[RESOURCE_MUSIC]);
+    text_batch_string(&text_batch, line, x, y);
+    y += line_height;
+
+    for (int state = 0; state <= RESOURCE_STATE_STARTUP; state++) {
+        size_t peak_ram = registry.state_peak_bytes[state][RESOURCE_CHUNK] + registry.state_peak_bytes[state][RESOURCE_FONT] + registry.state_peak_bytes[state][RESOURCE_MUSIC];
+        snprintf(line, sizeof(line), "%s%s: %.1f / %.1f MB", state == registry.state ? "> " : "  ", resource_state_name(state),
+                 registry.state_peak_bytes[state][RESOURCE_TEXTURE] / 1048576.0, peak_ram / 1048576.0);
+        text_batch_string(&text_batch, line, x, y);
+        y += line_height;
+    }
+    text_batch_flush(render, &text_batch);
+    return y + 4;
+}
+
+void resource_report(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Error writing resource report %s\n", path);
+        return;
+    }
+
+    fprintf(file, "{\"live\":{");
+    for (int kind = 0; kind < RESOURCE_KIND_COUNT; kind++) {
+        fprintf(file, "%s\"%s\":{\"count\":%d,\"peak\":%d,\"bytes\":%zu}", kind ? "," : "", resource_kind_names[kind],
+                registry.live[kind], registry.peak[kind], registry.bytes[kind]);
+    }
+
+    fprintf(file, "},\"states\":[");
+    for (int state = 0; state <= RESOURCE_STATE_STARTUP; state++) {
+        fprintf(file, "%s{\"state\":\"%s\"", state ? "," : "", resource_state_name(state));
+        for (int kind = 0; kind < RESOURCE_KIND_COUNT; kind++) {
+            fprintf(file, ",\"%s\":{\"peak\":%d,\"peak_bytes\":%zu}", resource_kind_names[kind],
+                    registry.state_peak[state][kind], registry.state_peak_bytes[state][kind]);
         }
+        fprintf(file, "}");
     }
 
-    return false;
+    // O que ainda está vivo aqui escapou das liberações explícitas e só cai no resource_release_all:
+    fprintf(file, "],\"live_at_exit\":[");
+    bool first = true;
+    for (int i = 0; i < registry.slot_count; i++) {
+        ResourceSlot *entry = &registry.slots[i];
+        if (!entry->pointer) continue;
+
+        fprintf(file, "%s{\"kind\":\"%s\",\"name\":", first ? "" : ",", resource_kind_names[entry->kind]);
+        trace_write_string(file, entry->name);
+        fprintf(file, ",\"w\":%d,\"h\":%d,\"format\":", entry->w, entry->h);
+        trace_write_string(file, entry->format ? SDL_GetPixelFormatName(entry->format) : "");
+        fprintf(file, ",\"bytes\":%zu,\"refcount\":%d}", entry->bytes, entry->refcount);
+        first = false;
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+}
+
+void resource_release_all(void) {
+    for (int i = 0; i < registry.slot_count; i++) {
+        ResourceSlot *entry = &registry.slots[i];
+        if (entry->pointer) resource_destroy(entry->pointer, entry->kind);
+    }
+
+    free(registry.slots);
+    free(registry.index);
+    memset(&registry, 0, sizeof(registry));
+    registry.free_head = -1;
+}
+
+static void track_sprite(Sprite *sprite) {
+    if (!sprite) {
+        return;
+    }
+
+    if (guarded_sprites_count >= guarded_sprites_capacity) {
+        guarded_sprites_capacity = guarded_sprites_capacity ? guarded_sprites_capacity * 2 : 128;
+        guarded_sprites = realloc(guarded_sprites, guarded_sprites_capacity * sizeof(*guarded_sprites));
+    }
+
+    guarded_sprites[guarded_sprites_count++] = sprite;
 }
 
 void game_cleanup(Game *game, int exit_status) {
@@ -4364,9 +9715,52 @@ void game_cleanup(Game *game, int exit_status) {
         Mix_HaltChannel(i);
     }
 
+    loader_finish();
     Mix_CloseAudio();
 
+    residency_shutdown();
+    flight_shutdown(&flight_recorder);
+    trace_shutdown();
+    atlas_unload();
+    if (print_stats && text_stats.quads > 0) {
+        printf("Text: %llu glyph quads submitted in %llu draw calls.\n", (unsigned long long)text_stats.quads, (unsigned long long)text_stats.draw_calls);
+    }
+    if (print_stats && parallax_cache.recomposed > 0) {
+        Uint64 parallax_frames = parallax_cache.recomposed + parallax_cache.reused;
+        printf("Parallax: %llu frames recomposed, %llu drawn from cache (%.1f%% hits).\n", (unsigned long long)parallax_cache.recomposed,
+               (unsigned long long)parallax_cache.reused, 100.0 * parallax_cache.reused / parallax_frames);
+    }
+    if (print_stats && sim_clock.ticks > 0) {
+        printf("Simulation: %llu ticks at %d Hz over %llu frames (%llu replayed), %d stalls dropped %.2fs.\n", (unsigned long long)sim_clock.ticks, SIM_TICK_RATE,
+               (unsigned long long)sim_clock.frames, (unsigned long long)sim_clock.replays, sim_clock.stalls, sim_clock.dropped);
+    }
+    headless_report(&headless);
+    counters_report(&hardware_counters);
+    counters_shutdown(&hardware_counters);
+    sampler_shutdown(&sampler);
+    if (print_stats && frame_pacer.frames > 1) {
+        double waited = frame_pacer.slept + frame_pacer.spun;
+        printf("Frame pacing: %s, target %d fps, %.1f%% of waiting spent spinning.\n", frame_pacer.vsync ? "vsync" : "no vsync",
+               frame_pacer.period ? (int)(frame_pacer.frequency / frame_pacer.period) : 0, waited > 0.0 ? 100.0 * frame_pacer.spun / waited : 0.0);
+    }
+    if (print_stats && render_queue.frames > 0 && render_queue.total_draw_calls > 0) {
+        printf("Render queue: %.1f commands in %.1f draw calls per frame, %.1f state changes elided.\n", (double)render_queue.total_commands / render_queue.frames,
+               (double)render_queue.total_draw_calls / render_queue.frames, (double)render_queue.total_elided / render_queue.frames);
+    }
+    if (print_stats && cull_stats.frames > 0) {
+        printf("Culling: %.1f sprites culled and %.1f clipped per frame.\n", (double)cull_stats.total_culled / cull_stats.frames, (double)cull_stats.total_clipped / cull_stats.frames);
+    }
+    if (print_stats && dirty_renderer.frames > 0) {
+        printf("Dirty rects: %.1f%% of static-screen pixels repainted over %llu frames.\n",
+               100.0 * dirty_renderer.repainted_pixels / ((double)dirty_renderer.frames * SCREEN_WIDTH * SCREEN_HEIGHT), (unsigned long long)dirty_renderer.frames);
+    }
+    text_batch_free(&text_batch);
+    render_queue_free();
+    glyph_atlas_clear();
+    cache_clear(&texture_cache);
+    cache_clear(&font_cache);
     clean_tracked_resources();
+    pack_close();
     SDL_DestroyRenderer(game->renderer);
     SDL_DestroyWindow(game->window);
 
@@ -4379,32 +9773,21 @@ void game_cleanup(Game *game, int exit_status) {
 }
 
 void clean_tracked_resources(void) {
-    for (int i = 0; i < guarded_textures_count; i++) {
-        if (guarded_textures[i]) {
-            SDL_DestroyTexture(guarded_textures[i]);
-        }
-    }
-    free(guarded_textures);
-    guarded_textures = NULL;
-    guarded_textures_count = guarded_textures_capacity = 0;
-
-    for (int i = 0; i < guarded_chunks_count; i++) {
-        if (guarded_chunks[i]) {
-            Mix_FreeChunk(guarded_chunks[i]);
-        }
+    if (print_stats) {
+        ResourceStats stats = resource_stats();
+        printf("Resources: %llu registered, %llu released, peak %d textures / %d chunks / %d fonts / %d music, %.2f probes per lookup.\n",
+               (unsigned long long)stats.registrations, (unsigned long long)stats.releases, stats.peak[RESOURCE_TEXTURE],
+               stats.peak[RESOURCE_CHUNK], stats.peak[RESOURCE_FONT], stats.peak[RESOURCE_MUSIC], stats.average_probes);
     }
-    free(guarded_chunks);
-    guarded_chunks = NULL;
-    guarded_chunks_count = guarded_chunks_capacity = 0;
+    resource_report(RESOURCE_REPORT_PATH);
+    resource_release_all();
 
-    for (int i = 0; i < guarded_fonts_count; i++) {
-        if (guarded_fonts[i]) {
-            TTF_CloseFont(guarded_fonts[i]);
-        }
+    for (int i = 0; i < guarded_sprites_count; i++) {
+        free(guarded_sprites[i]);
     }
-    free(guarded_fonts);
-    guarded_fonts = NULL;
-    guarded_fonts_count = guarded_fonts_capacity = 0;
+    free(guarded_sprites);
+    guarded_sprites = NULL;
+    guarded_sprites_count = guarded_sprites_capacity = 0;
 }
 
 static int utf8_charlen(const char *s) {
@@ -4426,19 +9809,130 @@ static int utf8_copy_char(const char *s, char *out) {
     out[n] = '\0';
     return n;
 }
+static Uint32 utf8_decode(const char *s) {
+    const unsigned char *u = (const unsigned char *)s;
+    int n = utf8_charlen(s);
+    if (n == 1) return u[0];
+
+    Uint32 codepoint = u[0] & (0x7F >> n);
+    for (int i = 1; i < n && (u[i] & 0xC0) == 0x80; i++) {
+        codepoint = (codepoint << 6) | (u[i] & 0x3F);
+    }
+
+    return codepoint;
+}
+
+static Uint32 hash_string(const char *s) {
+    Uint32 hash = 2166136261u;
+    while (*s) {
+        hash ^= (unsigned char)*s++;
+        hash *= 16777619u;
+    }
 
-int renderitem_cmp(const void *pa, const void *pb) {
-    const RenderItem *a = (const RenderItem *)pa;
-    const RenderItem *b = (const RenderItem *)pb;
+    return hash;
+}
+
+static Uint64 hash_bytes(Uint64 hash, const void *data, size_t size) {
+    const Uint8 *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+static Uint64 hash_words(Uint64 hash, const void *data, size_t size) {
+    // Oito bytes por passo para os pixels; o resto da linha cai no FNV byte a byte.
+    const Uint8 *bytes = data;
+    size_t words = size / sizeof(Uint64);
+    for (size_t i = 0; i < words; i++) {
+        Uint64 word;
+        memcpy(&word, bytes + i * sizeof(Uint64), sizeof(Uint64));
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+
+    return hash_bytes(hash, bytes + words * sizeof(Uint64), size % sizeof(Uint64));
+}
+
+static void collect_files(const char *dir, const char *ext, char ***paths, int *count, int *capacity) {
+    DIR *handle = opendir(dir);
+    if (!handle) return;
+
+    size_t ext_len = strlen(ext);
+    struct dirent *entry;
+    while ((entry = readdir(handle))) {
+        if (entry->d_name[0] == '.') continue;
+
+        char path[PATH_LENGTH];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+
+        struct stat info;
+        if (stat(path, &info)) continue;
+        if (S_ISDIR(info.st_mode)) {
+            collect_files(path, ext, paths, count, capacity);
+            continue;
+        }
+
+        size_t len = strlen(path);
+        if (len < ext_len || strcmp(path + len - ext_len, ext) != 0) continue;
+
+        if (*count >= *capacity) {
+            *capacity = *capacity ? *capacity * 2 : 128;
+            *paths = realloc(*paths, *capacity * sizeof(**paths));
+        }
+        (*paths)[(*count)++] = strdup(path);
+    }
+
+    closedir(handle);
+}
+
+static bool make_directory(const char *dir) {
+    struct stat info;
+    if (stat(dir, &info) == 0) return !S_ISDIR(info.st_mode);
+
+#ifdef _WIN32
+    return mkdir(dir) != 0;
+#else
+    return mkdir(dir, 0755) != 0;
+#endif
+}
+
+int atlas_source_cmp(const void *pa, const void *pb) {
+    const AtlasSource *a = (const AtlasSource *)pa;
+    const AtlasSource *b = (const AtlasSource *)pb;
+
+    int bucket = strcmp(a->bucket, b->bucket);
+    if (bucket) return bucket;
+    if (a->surface->h != b->surface->h) return b->surface->h - a->surface->h;
+    if (a->surface->w != b->surface->w) return b->surface->w - a->surface->w;
+
+    return strcmp(a->path, b->path);
+}
+
+int profile_event_cmp(const void *pa, const void *pb) {
+    const ProfileEvent *a = (const ProfileEvent *)pa;
+    const ProfileEvent *b = (const ProfileEvent *)pb;
+    Uint64 da = a->end - a->start;
+    Uint64 db = b->end - b->start;
+
+    if (da > db) return -1;
+    if (da < db) return 1;
 
-    int da = a->collisions->y + a->collisions->h;
-    int db = b->collisions->y + b->collisions->h;
-    if (da < db) return -1;
-    if (da > db) return 1;
-    
     return 0;
 }
 
+int load_job_cmp(const void *pa, const void *pb) {
+    const LoadJob *a = (const LoadJob *)pa;
+    const LoadJob *b = (const LoadJob *)pb;
+
+    if (a->bytes > b->bytes) return -1;
+    if (a->bytes < b->bytes) return 1;
+
+    return strcmp(a->path, b->path);
+}
+
 int randint(int min, int max) {
     return min + rand() % (max - min + 1);
 }